@@ -26,6 +26,12 @@ const pinTypeReserved = 2;
 const pinTypeSpi = 3;
 const pinTypeInvalid = UINT8_MAX;
 let sysInfo = {};
+let binaryVars = []; //var ids by nr, for binary values (see SysModWeb)
+let channels = []; //channel names by nr, for binary streams (see SysModWeb::addChannel)
+let visibleSent = null; //modules shown, as last send to the server (see sendVisible)
+let visibleTimeout = null;
+let subscribed = new Set(); //canvas ids subscribed to a binary stream, only of modules shown (see sendVisible)
+let fragments = []; //parts of a json message over the ws size limit, send as binary fragments (see SysModWeb::sendDataWsFragments)
 function getPinType(pinNr) {
   if (sysInfo.pinTypes[pinNr] == pinTypeIO) return "🟢";
   else if (sysInfo.pinTypes[pinNr] == pinTypeReadOnly) return "🟠";
@@ -33,6 +39,15 @@ function getPinType(pinNr) {
   else return "🔴";
 }
 
+//var types are send as numbers, names in sysInfo.varTypes (see varTypeInfo in SysModModel)
+function varTypesToNames(variable) {
+  if (typeof variable.type == "number" && sysInfo.varTypes)
+    variable.type = sysInfo.varTypes[variable.type];
+  if (variable.n)
+    for (let childVar of variable.n)
+      varTypesToNames(childVar);
+}
+
 function gId(c) {return d.getElementById(c);}
 function cE(e) { return d.createElement(e); }
 
@@ -84,7 +99,24 @@ function makeWS() {
   ws.onmessage = (e)=>{
     if (e.data instanceof ArrayBuffer) { // preview packet
       let buffer = new Uint8Array(e.data);
-      if (buffer[0]==0) {
+      if (buffer[0]==250) //binary values
+        receiveBinaryValues(e.data);
+      else if (buffer[0]==251) { //fragment of a json message: flags (1: first, 2: last), part of the text
+        if (buffer[1] & 1) fragments = [];
+        fragments.push(buffer.subarray(2));
+        if (buffer[1] & 2) {
+          let bytes = new Uint8Array(fragments.reduce((length, part) => length + part.length, 0));
+          let offset = 0;
+          for (let part of fragments) {
+            bytes.set(part, offset);
+            offset += part.length;
+          }
+          let text = new TextDecoder().decode(bytes);
+          fragments = [];
+          ws.onmessage({data: text}); //handled as a text message
+        }
+      }
+      else if (channels[buffer[0]] == "board") {
         let pviewNode = gId("board");
         // console.log(buffer, pviewNode);
         previewBoard(pviewNode, buffer);
@@ -107,6 +139,7 @@ function makeWS() {
           console.error("makeWS json error", error, e.data); // error in the above string (in this case, yes)!
       }
       if (json) {
+        if (typeof json.type == "number") varTypesToNames(json);
         //receive model per module to stay under websocket size limit of 8192
         if (json.type && ["appmod","usermod", "sysmod"].includes(json.type)) { //generate array of variables
           let found = false;
@@ -164,6 +197,10 @@ function makeWS() {
   ws.onopen = (e)=>{
     console.log("WS open", e);
 		reqsLegal = true;
+    ws.send('{"binary":true}'); //values as binary frames, server answers with binaryVars
+    subscribed = new Set(); //new connection: no streams until subscribed again
+    visibleSent = null; //new connection: server sends all modules until told otherwise
+    sendVisible();
   }
   ws.onerror = (e)=>{
     console.log("WS error", e);
@@ -604,6 +641,43 @@ function varRemoveValuesForRow(variable, rowNr) {
 }
 
 //process json from server, json is assumed to be an object
+//binary values frame: 250, then per value: var nr (uint16), rowNr (uint8, 255: no row), tag (uint8), value (little endian)
+//converted to json as send by the server: {id:{"value":value}} or {id:{"cells":{rowNr:value}}}
+function receiveBinaryValues(buffer) {
+  let view = new DataView(buffer);
+  let json = {};
+  let offset = 1;
+  while (offset + 4 <= view.byteLength) {
+    let id = binaryVars[view.getUint16(offset, true)];
+    let rowNr = view.getUint8(offset + 2);
+    let tag = view.getUint8(offset + 3);
+    offset += 4;
+    let value;
+    if (tag == 1) { value = view.getUint8(offset) != 0; offset += 1; }
+    else if (tag == 2) { value = view.getInt32(offset, true); offset += 4; }
+    else if (tag == 3) { value = view.getUint32(offset, true); offset += 4; }
+    else if (tag == 4) { value = view.getFloat64(offset, true); offset += 8; }
+    else if (tag == 5) {
+      let len = view.getUint16(offset, true);
+      value = new TextDecoder().decode(new Uint8Array(buffer, offset + 2, len));
+      offset += 2 + len;
+    }
+    else {
+      console.log("dev receiveBinaryValues unknown tag", tag);
+      break;
+    }
+    if (!id) continue;
+    if (!json[id]) json[id] = {};
+    if (rowNr == UINT8_MAX)
+      json[id].value = value;
+    else {
+      if (!json[id].cells) json[id].cells = {};
+      json[id].cells[rowNr] = value;
+    }
+  }
+  receiveData(json);
+}
+
 function receiveData(json) {
   // console.log("receiveData", json);
 
@@ -629,6 +703,7 @@ function receiveData(json) {
         ppf("receiveData no action", key, value);
       } else if (key == "details") {
         let variable = value.var;
+        varTypesToNames(variable);
         let rowNr = value.rowNr == null?UINT8_MAX:value.rowNr;
         let nodeId = variable.id + ((rowNr != UINT8_MAX)?"#" + rowNr:"");
         //if var object with .n, create .n (e.g. see fx.onChange (setEffect) and fixtureGenonChange, tbd: )
@@ -703,6 +778,12 @@ function receiveData(json) {
           colNr++;
         }
 
+      } else if (key == "channels") {
+        ppf("receiveData", key, value);
+        for (let name in value) channels[value[name]] = name;
+      } else if (key == "binaryVars") {
+        ppf("receiveData", key, value.length);
+        binaryVars = value;
       } else if (key == "sysInfo") { //update the row of a table
         ppf("receiveData", key, value.board);
         sysInfo = value;
@@ -716,8 +797,24 @@ function receiveData(json) {
           //   ppf("receiveData ", variable, value);
           variable.fun = -2; // request processed
 
+          let cells = value.cells; //changed cells of a table column {rowNr: value}
+          delete value.cells;
+
           value.chk = "onUI";
           changeHTML(variable, value, rowNr); //changeHTML will find the rownumbers if needed
+
+          if (cells) {
+            for (let [cellRowNr, cellValue] of Object.entries(cells)) {
+              cellRowNr = parseInt(cellRowNr);
+              if (gId(variable.id + "#" + cellRowNr))
+                changeHTML(variable, {"value":cellValue, "chk":"cell"}, cellRowNr);
+              else { //new row: update the whole column (creates the row)
+                if (!Array.isArray(variable.value)) variable.value = [];
+                variable.value[cellRowNr] = cellValue;
+                changeHTML(variable, {"value":variable.value, "chk":"cells"});
+              }
+            }
+          }
         }
         else
           ppf("receiveData key is no variable", key, value);
@@ -1223,6 +1320,11 @@ function findParentVar(id, parent = model) {
 var jsonTimeout;
 var reqsLegal = false;
 
+//binary stream for a canvas, if the server has a channel with its id (answered with channels)
+function subscribeChannel(id, fps = 0) {
+  if (ws && ws.readyState == WebSocket.OPEN) ws.send(JSON.stringify({"subscribe":{[id]:fps}}));
+}
+
 function requestJson(command) {
   gId('connind').style.backgroundColor = "var(--c-y)";
 	if (command && !reqsLegal) return; // stop post requests from chrome onchange event on page restore
@@ -1565,8 +1667,44 @@ function changeHTMLView(viewName) {
 
   setInstanceTableColumns();
 
+  //modules arrive one by one after connect: tell the server once they are shown
+  clearTimeout(visibleTimeout);
+  visibleTimeout = setTimeout(sendVisible, 500);
+
 } //changeHTMLView
 
+//server only sends updates of the modules shown (and their current values when shown again)
+//  and the binary streams of the canvases shown
+function sendVisible() {
+  let visible = [];
+  let canvases = new Set();
+  for (let mdlColumnNode of gId("mdlContainer").childNodes) {
+    if (mdlColumnNode.hidden) continue;
+    for (let divNode of mdlColumnNode.childNodes) {
+      if (divNode.hidden || !divNode.childNodes) continue;
+      for (let moduleNode of divNode.childNodes) {
+        if (moduleNode.className && moduleNode.id) visible.push(moduleNode.id);
+        if (moduleNode.querySelectorAll)
+          for (let canvasNode of moduleNode.querySelectorAll("canvas"))
+            if (canvasNode.id) canvases.add(canvasNode.id);
+      }
+    }
+  }
+  if (ws && ws.readyState == WebSocket.OPEN) {
+    let unsubscribe = [...subscribed].filter((id) => !canvases.has(id));
+    if (unsubscribe.length) ws.send(JSON.stringify({"unsubscribe":unsubscribe}));
+    for (let id of canvases)
+      if (!subscribed.has(id)) subscribeChannel(id);
+    subscribed = canvases;
+  }
+  if (!visible.length) return; //no modules yet
+  let command = JSON.stringify({"visible":visible});
+  if (command != visibleSent && ws && ws.readyState == WebSocket.OPEN) {
+    ws.send(command);
+    visibleSent = command;
+  }
+}
+
 //https://webdesign.tutsplus.com/color-schemes-with-css-variables-and-javascript--cms-36989t
 function changeHTMLTheme(themeName) {
   localStorage.setItem('theme', themeName);
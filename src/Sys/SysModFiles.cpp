@@ -51,11 +51,15 @@ void SysModFiles::setup() {
       return true;
     default: return false;
   }});
+  fileTblRefresh.attach(tableVar);
 
   ui->initText(tableVar, "flName", nullptr, 32, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
-      for (forUnsigned8 rowNr = 0; rowNr < fileList.size(); rowNr++)
-        mdl->setValue(var, JsonString(fileList[rowNr].name, JsonString::Copied), rowNr);
+      flNameColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < fileList.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        flNameColumn.set(rowNrL, fileList[rowNrL].name);
+      if (rowNr == UINT8_MAX) flNameColumn.resize(fileList.size()); //remove rows of removed files
+      flNameColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Name");
@@ -65,8 +69,11 @@ void SysModFiles::setup() {
 
   ui->initNumber(tableVar, "flSize", UINT16_MAX, 0, UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
-      for (forUnsigned8 rowNr = 0; rowNr < fileList.size(); rowNr++)
-        mdl->setValue(var, fileList[rowNr].size, rowNr);
+      flSizeColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < fileList.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        flSizeColumn.set(rowNrL, fileList[rowNrL].size);
+      if (rowNr == UINT8_MAX) flSizeColumn.resize(fileList.size()); //remove rows of removed files
+      flSizeColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Size (B)");
@@ -76,11 +83,14 @@ void SysModFiles::setup() {
 
   ui->initURL(tableVar, "flLink", nullptr, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
-      for (forUnsigned8 rowNr = 0; rowNr < fileList.size(); rowNr++) {
+      flLinkColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < fileList.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
         char urlString[32] = "file/";
-        strncat(urlString, fileList[rowNr].name, sizeof(urlString)-1);
-        mdl->setValue(var, JsonString(urlString, JsonString::Copied), rowNr);
+        strncat(urlString, fileList[rowNrL].name, sizeof(urlString)-1);
+        flLinkColumn.set(rowNrL, urlString);
       }
+      if (rowNr == UINT8_MAX) flLinkColumn.resize(fileList.size()); //remove rows of removed files
+      flLinkColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Show");
@@ -116,7 +126,8 @@ void SysModFiles::loop20ms() {
     File file = root.openNextFile();
 
     //repopulate file list
-    fileList.clear();
+    std::vector<FileDetails> oldFileList;
+    oldFileList.swap(fileList);
     while (file) {
       FileDetails details;
       strcpy(details.name, file.name());
@@ -129,9 +140,16 @@ void SysModFiles::loop20ms() {
 
     mdl->setValue("drsize", files->usedBytes());
 
-    for (JsonObject childVar: mdl->varChildren("fileTbl"))
-      ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP)
+    //only rows of changed files (all rows if files added or removed)
+    if (fileList.size() != oldFileList.size())
+      fileTblRefresh.rowChanged();
+    else
+      for (forUnsigned8 rowNr = 0; rowNr < fileList.size(); rowNr++)
+        if (fileList[rowNr].size != oldFileList[rowNr].size || strcmp(fileList[rowNr].name, oldFileList[rowNr].name) != 0)
+          fileTblRefresh.rowChanged(rowNr);
   }
+
+  fileTblRefresh.refresh(fileList.size());
 }
 
 void SysModFiles::loop10s() {
@@ -144,6 +162,12 @@ bool SysModFiles::remove(const char * path) {
   filesChanged = true;
 }
 
+bool SysModFiles::rename(const char * pathFrom, const char * pathTo) {
+  ppf("File rename %s to %s\n", pathFrom, pathTo);
+  filesChanged = true;
+  return LittleFS.rename(pathFrom, pathTo);
+}
+
 size_t SysModFiles::usedBytes() {
   return LittleFS.usedBytes();
 }
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "SysModule.h"
+#include "SysModModel.h"
 #include "LittleFS.h"
 
 struct FileDetails {
@@ -33,6 +34,9 @@ public:
 
   bool remove(const char * path);
 
+  //replaces pathTo if it exists (atomic on LittleFS)
+  bool rename(const char * pathFrom, const char * pathTo);
+
   size_t usedBytes();
 
   size_t totalBytes();
@@ -57,6 +61,12 @@ public:
   //remove files meeting filter condition, if no filter, all, if reverse then all but filter
   void removeFiles(const char * filter = nullptr, bool reverse = false);
 
+private:
+  TableRefresh fileTblRefresh;
+  VarColumn<String> flNameColumn;
+  VarColumn<size_t> flSizeColumn;
+  VarColumn<String> flLinkColumn;
+
 };
 
 extern SysModFiles *files;
\ No newline at end of file
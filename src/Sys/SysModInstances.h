@@ -41,6 +41,9 @@ struct VarData {
 
 //note: changing SysData and jsonData sizes: all instances should have the same version so change with care
 
+//first VERSION which handles {"vars":{"id":value, ...}} messages, older instances only {"id":..., "value":...}
+#define VARS_MESSAGE_VERSION 24062116
+
 struct InstanceInfo {
   IPAddress ip;
   char name[32];
@@ -120,11 +123,15 @@ public:
         return true;
       default: return false;
     }});
+    insTblRefresh.attach(tableVar);
     
     ui->initText(tableVar, "insName", nullptr, 32, false, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, JsonString(instances[rowNrL].name, JsonString::Copied), rowNrL);
+        insNameColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insNameColumn.set(rowNrL, instances[rowNrL].name);
+        if (rowNr == UINT8_MAX) insNameColumn.resize(instances.size()); //remove rows of removed instances
+        insNameColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Name");
@@ -139,11 +146,14 @@ public:
 
     ui->initURL(tableVar, "insShow", nullptr, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
+        insShowColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
           char urlString[32] = "http://";
           strncat(urlString, instances[rowNrL].ip.toString().c_str(), sizeof(urlString)-1);
-          mdl->setValue(var, JsonString(urlString, JsonString::Copied), rowNrL);
+          insShowColumn.set(rowNrL, urlString);
         }
+        if (rowNr == UINT8_MAX) insShowColumn.resize(instances.size()); //remove rows of removed instances
+        insShowColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Show");
@@ -153,8 +163,11 @@ public:
 
     ui->initNumber(tableVar, "insLink", UINT16_MAX, 0, UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, calcGroup(instances[rowNrL].name), rowNrL);
+        insLinkColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insLinkColumn.set(rowNrL, calcGroup(instances[rowNrL].name));
+        if (rowNr == UINT8_MAX) insLinkColumn.resize(instances.size()); //remove rows of removed instances
+        insLinkColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Link");
@@ -164,8 +177,11 @@ public:
 
     ui->initText(tableVar, "insIp", nullptr, 16, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, JsonString(instances[rowNrL].ip.toString().c_str(), JsonString::Copied), rowNrL);
+        insIpColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insIpColumn.set(rowNrL, instances[rowNrL].ip.toString());
+        if (rowNr == UINT8_MAX) insIpColumn.resize(instances.size()); //remove rows of removed instances
+        insIpColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "IP");
@@ -175,10 +191,13 @@ public:
 
     ui->initText(tableVar, "insType", nullptr, 16, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
+        insTypeColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
           byte type = instances[rowNrL].sysData.type;
-          mdl->setValue(var, (type==0)?"WLED":(type==1)?"StarBase":(type==2)?"StarLight":(type==3)?"StarLedsLive":"StarFork", rowNrL);
+          insTypeColumn.set(rowNrL, (type==0)?"WLED":(type==1)?"StarBase":(type==2)?"StarLight":(type==3)?"StarLedsLive":"StarFork");
         }
+        if (rowNr == UINT8_MAX) insTypeColumn.resize(instances.size()); //remove rows of removed instances
+        insTypeColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Type");
@@ -188,8 +207,11 @@ public:
 
     ui->initNumber(tableVar, "insVersion", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, instances[rowNrL].version, rowNrL);
+        insVersionColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insVersionColumn.set(rowNrL, instances[rowNrL].version);
+        if (rowNr == UINT8_MAX) insVersionColumn.resize(instances.size()); //remove rows of removed instances
+        insVersionColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Version");
@@ -199,8 +221,11 @@ public:
 
     ui->initNumber(tableVar, "insUp", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, instances[rowNrL].sysData.upTime, rowNrL);
+        insUpColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insUpColumn.set(rowNrL, instances[rowNrL].sysData.upTime);
+        if (rowNr == UINT8_MAX) insUpColumn.resize(instances.size()); //remove rows of removed instances
+        insUpColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Uptime");
@@ -209,8 +234,11 @@ public:
     }});
     ui->initNumber(tableVar, "insNow", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, instances[rowNrL].sysData.now / 1000, rowNrL);
+        insNowColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insNowColumn.set(rowNrL, instances[rowNrL].sysData.now / 1000);
+        if (rowNr == UINT8_MAX) insNowColumn.resize(instances.size()); //remove rows of removed instances
+        insNowColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Now");
@@ -220,8 +248,11 @@ public:
 
     ui->initNumber(tableVar, "insTS", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, instances[rowNrL].sysData.timeSource, rowNrL);
+        insTSColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insTSColumn.set(rowNrL, instances[rowNrL].sysData.timeSource);
+        if (rowNr == UINT8_MAX) insTSColumn.resize(instances.size()); //remove rows of removed instances
+        insTSColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "TS");
@@ -231,8 +262,11 @@ public:
 
     ui->initNumber(tableVar, "insTT", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, instances[rowNrL].sysData.tokiTime, rowNrL);
+        insTTColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insTTColumn.set(rowNrL, instances[rowNrL].sysData.tokiTime);
+        if (rowNr == UINT8_MAX) insTTColumn.resize(instances.size()); //remove rows of removed instances
+        insTTColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Time");
@@ -242,8 +276,11 @@ public:
 
     ui->initNumber(tableVar, "insTM", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
-        for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
-          mdl->setValue(var, instances[rowNrL].sysData.tokiMs, rowNrL);
+        insTMColumn.attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          insTMColumn.set(rowNrL, instances[rowNrL].sysData.tokiMs);
+        if (rowNr == UINT8_MAX) insTMColumn.resize(instances.size()); //remove rows of removed instances
+        insTMColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Ms");
@@ -263,15 +300,15 @@ public:
       JsonObject insVar; // = ui->cloneVar(var, columnVarID, [this, var](JsonObject insVar){});
 
       //create a var of the same type. InitVar is not calling onChange which is good in this situation!
-      insVar = ui->initVar(tableVar, columnVarID, var["type"], false, [this, var](JsonObject insVar, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+      insVar = ui->initVar(tableVar, columnVarID, mdl->varType(var), false, [this, var](JsonObject insVar, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
         case onSetValue:
           //should not trigger onChange
-          for (forUnsigned8 rowNrL = 0; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
+          for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < instances.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
             // ppf("initVar dash %s[%d]\n", mdl->varID(insVar), rowNrL);
             //do what setValue is doing except calling onChange
             // insVar["value"][rowNrL] = instances[rowNrL].jsonData[mdl->varID(var)]; //only int values...
 
-            web->addResponse(insVar["id"], "value", instances[rowNrL].jsonData[mdl->varID(var)], rowNrL);
+            web->addResponseCell(insVar["id"], rowNrL, instances[rowNrL].jsonData[mdl->varID(var)]);
 
             // mdl->setValue(insVar, instances[rowNrL].jsonData[mdl->varID(var)], rowNr);
           //send to ws?
@@ -340,11 +377,20 @@ public:
 
     handleNotifications();
 
-    while (changedVarsQueue.size()) {
-      JsonObject var = changedVarsQueue.front();
-      sendMessageUDP(IPAddress(255, 255, 255, 255), var["id"], var["value"]); //broadcast
-      changedVarsQueue.erase(changedVarsQueue.begin());
+    insTblRefresh.refresh(instances.size());
+
+    if (changedVarsQueue.size() == 1 || (changedVarsQueue.size() > 1 && !groupHandlesVarsMessage())) {
+      for (JsonObject var: changedVarsQueue)
+        sendMessageUDP(IPAddress(255, 255, 255, 255), var["id"], var["value"]); //broadcast
     }
+    else if (changedVarsQueue.size() > 1) { //e.g. a batch: all vars in one message {"vars":{"id":value, ...}}
+      JsonDocument message;
+      JsonObject vars = message["vars"].to<JsonObject>();
+      for (JsonObject var: changedVarsQueue)
+        vars[mdl->varID(var)] = var["value"];
+      sendJsonUDP(IPAddress(255, 255, 255, 255), message); //broadcast
+    }
+    changedVarsQueue.clear();
 
   }
 
@@ -373,6 +419,19 @@ public:
 
   }
 
+  //all other StarBase instances of the group of this instance handle vars messages (version), else send each var
+  bool groupHandlesVarsMessage() {
+    char group1[32];
+    char group2[32];
+    if (!groupOfName(mdl->getValue("name"), group2)) return true; //no group: vars messages are not handled anyway
+    for (InstanceInfo &instance: instances) {
+      if (instance.sysData.type >= 1 && instance.ip != WiFi.localIP() && instance.version < VARS_MESSAGE_VERSION
+            && groupOfName(instance.name, group1) && strcmp(group1, group2) == 0)
+        return false;
+    }
+    return true;
+  }
+
   // identify if an instance belongs to a group: 0: no, 1: group of 1, >1: group with more
   uint8_t calcGroup(const char * insName) {
     uint8_t calc = 0;
@@ -464,8 +523,7 @@ public:
           // Serial.println();
 
           ppf("insTbl handleNotifications %d\n", notifierUdp.remoteIP()[3]);
-          for (JsonObject childVar: mdl->varChildren("insTbl"))
-            ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP) ); //rowNr //instance - instances.begin()
+          insTblRefresh.rowChanged(instance - &instances[0]);
 
           web->recvUDPCounter++;
           web->recvUDPBytes+=packetSize;
@@ -531,6 +589,14 @@ public:
 
                     mdl->setValueJV(message["id"].as<const char *>(), message["value"]);
                   }
+                  else if (message["vars"].is<JsonObject>()) {
+                    ppf("handleNotifications i:%d json message %.*s l:%d\n", instanceUDP.remoteIP()[3], packetSize, buffer, packetSize);
+
+                    mdl->beginBatch();
+                    for (JsonPair pair: message["vars"].as<JsonObject>())
+                      mdl->setValueJV(pair.key().c_str(), pair.value());
+                    mdl->commitBatch();
+                  }
                 }
               }
             else
@@ -558,8 +624,7 @@ public:
     }
     if (erased) {
       ppf("insTbl remove inactive instances\n");
-      for (JsonObject childVar: mdl->varChildren("insTbl"))
-        ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP)); //no rowNr so all rows updated
+      insTblRefresh.rowChanged(); //all rows
 
       ui->callVarFun("ddpInst", UINT8_MAX, onUI); //rebuild options
       ui->callVarFun("artInst", UINT8_MAX, onUI); //rebuild options
@@ -658,11 +723,14 @@ public:
 
   //sends an UDP message to a specific ip. Broadcast?
   void sendMessageUDP(IPAddress ip, const char * id, JsonVariant value) {
-    if (0 != instanceUDP.beginPacket(ip, instanceUDPPort)) {
+    JsonDocument message;
+    message["id"] = id;
+    message["value"] = value;
+    sendJsonUDP(ip, message);
+  }
 
-      JsonDocument message;
-      message["id"] = id;
-      message["value"] = value;
+  void sendJsonUDP(IPAddress ip, JsonDocument &message) {
+    if (0 != instanceUDP.beginPacket(ip, instanceUDPPort)) {
 
       size_t len = measureJson(message);
 
@@ -766,11 +834,13 @@ public:
               else {
                 //check if instance belongs to the same group
 
+                mdl->beginBatch(); //onChange once per var after all vars are set
                 for (JsonPair pair: newData.as<JsonObject>()) {
                   // ppf("updateInstance sync from i:%s k:%s v:%s\n", instance.name, pair.key().c_str(), pair.value().as<String>().c_str());
 
                   mdl->setValueJV(pair.key().c_str(), pair.value());
                 }
+                mdl->commitBatch();
                 instance.jsonData = newData; // deepcopy: https://github.com/bblanchon/ArduinoJson/issues/1023
                 // ppf("updateInstance json ip:%d", instance.ip[3]);
                 // print->printJson(" d:", instance.jsonData);
@@ -796,10 +866,7 @@ public:
 
           // ppf("updateInstance updRow\n");
 
-          for (JsonObject childVar: mdl->varChildren("insTbl"))
-            ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP)); //rowNr instance - instances.begin()
-
-          //tbd: now done for all rows, should be done only for updated rows!
+          insTblRefresh.rowChanged(&instance - &instances[0]);
         }
 
       } //ip
@@ -816,9 +883,7 @@ public:
       //run though it sorted to find the right rowNr
       // for (std::vector<InstanceInfo>::iterator instance=instances.begin(); instance!=instances.end(); ++instance) {
       //   if (instance->ip == messageIP) {
-          for (JsonObject childVar: mdl->varChildren("insTbl")) {
-            ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP)); //no rowNr, update all
-          }
+          insTblRefresh.rowChanged(); //rows sorted by name, update all
       //   }
       // }
     }
@@ -837,6 +902,7 @@ public:
       instance.ip = ip;
       instances.push_back(instance);
       std::sort(instances.begin(),instances.end(), [](InstanceInfo &a, InstanceInfo &b){ return strcmp(a.name,b.name)<0; });
+      insTblRefresh.rowChanged(); //rows sorted by name, update all
     }
 
     // InstanceInfo foundInstance;
@@ -861,6 +927,21 @@ public:
     unsigned16 instanceUDPPort = 65506;
     bool udp2Connected = false;
 
+    TableRefresh insTblRefresh;
+
+    //insTbl columns (dash columns are not stored)
+    VarColumn<String> insNameColumn;
+    VarColumn<String> insShowColumn;
+    VarColumn<uint8_t> insLinkColumn;
+    VarColumn<String> insIpColumn;
+    VarColumn<String> insTypeColumn;
+    VarColumn<uint32_t> insVersionColumn;
+    VarColumn<unsigned long> insUpColumn;
+    VarColumn<uint32_t> insNowColumn;
+    VarColumn<uint8_t> insTSColumn;
+    VarColumn<uint32_t> insTTColumn;
+    VarColumn<uint16_t> insTMColumn;
+
 };
 
 extern SysModInstances *instances;
\ No newline at end of file
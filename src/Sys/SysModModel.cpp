@@ -16,18 +16,85 @@
 #include "SysModUI.h"
 #include "SysModInstances.h"
 
+//model snapshot (/model.mpk): header followed by the model in MessagePack, written together with /model.json
+//the header contains the size and hash of the /model.json it was made with, so a replaced, edited or deleted model.json wins
+static const byte snapshotMagic[4] = {'S', 'B', 'M', 2}; //2: version
+
+//batch of each task (loopTask, async_tcp, module tasks), task local: batches of different tasks do not mix
+static thread_local unsigned8 batchLevel = 0; //nesting of beginBatch
+static thread_local std::vector<VarChange> * batchChanges = nullptr; //in order of first change, each var / row once
+
 SysModModel::SysModModel() :SysModule("Model") {
   model = new JsonDocument(&allocator);
 
   JsonArray root = model->to<JsonArray>(); //create
 
-  ppf("Reading model from /model.json... (deserializeConfigFromFS)\n");
-  if (files->readObjectFromFile("/model.json", model)) {//not part of success...
-    // print->printJson("Read model", *model);
-    // web->sendDataWs(*model);
-  } else {
-    root = model->to<JsonArray>(); //re create the model as it is corrupted by readFromFile
+  unsigned long start = millis();
+  if (readModelSnapshot(model)) {
+    ppf("Read model from /model.mpk in %lu ms\n", millis() - start);
+  }
+  else {
+    root = model->to<JsonArray>(); //re create the model as it can be corrupted by readModelSnapshot
+
+    ppf("Reading model from /model.json... (deserializeConfigFromFS)\n");
+    if (files->readObjectFromFile("/model.json", model)) {//not part of success...
+      // print->printJson("Read model", *model);
+      // web->sendDataWs(*model);
+      ppf("Read model from /model.json in %lu ms\n", millis() - start);
+    } else {
+      root = model->to<JsonArray>(); //re create the model as it is corrupted by readFromFile
+    }
+  }
+
+  replayJournal(); //changes since the last compaction
+}
+
+uint32_t SysModModel::fileHash(const char * path, uint32_t * size) {
+  File f = files->open(path, "r");
+  *size = f?f.size():0;
+  uint32_t hash = 2166136261; //FNV-1a, as varIdHash
+  byte buffer[256];
+  size_t len;
+  while (f && (len = f.read(buffer, sizeof(buffer))) > 0) {
+    for (size_t i = 0; i < len; i++) {
+      hash ^= buffer[i];
+      hash *= 16777619;
+    }
+  }
+  f.close();
+  return hash;
+}
+
+bool SysModModel::readModelSnapshot(JsonDocument *doc) {
+  if (!LittleFS.exists("/model.mpk")) return false;
+
+  File f = files->open("/model.mpk", "r");
+  if (!f) return false;
+
+  byte magic[sizeof(snapshotMagic)];
+  uint32_t jsonSize = 0;
+  uint32_t jsonHash = 0;
+  bool valid = f.read(magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, snapshotMagic, sizeof(magic)) == 0
+            && f.read((byte *)&jsonSize, sizeof(jsonSize)) == sizeof(jsonSize)
+            && f.read((byte *)&jsonHash, sizeof(jsonHash)) == sizeof(jsonHash);
+  if (valid) {
+    uint32_t size;
+    valid = fileHash("/model.json", &size) == jsonHash && size == jsonSize; //reading is much faster than parsing
+  }
+
+  if (!valid) {
+    ppf("readModelSnapshot /model.mpk outdated or invalid, using /model.json\n");
+    f.close();
+    return false;
+  }
+
+  DeserializationError error = deserializeMsgPack(*doc, f, DeserializationOption::NestingLimit(20)); //as readObjectFromFile
+  f.close();
+  if (error || !doc->is<JsonArray>()) {
+    ppf("readModelSnapshot deserializeMsgPack failed with code %s\n", error.c_str());
+    return false;
   }
+  return true;
 }
 
 void SysModModel::setup() {
@@ -38,7 +105,7 @@ void SysModModel::setup() {
 
   ui->initButton(parentVar, "saveModel", false, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
-      ui->setComment(var, "Write to model.json");
+      ui->setComment(var, "Write to model.json (changes are also saved automatically)");
       return true;
     case onChange:
       doWriteModel = true;
@@ -46,6 +113,22 @@ void SysModModel::setup() {
     default: return false;
   }});
 
+  ui->initText(parentVar, "mdlMem", nullptr, 32, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setLabel(var, "Memory");
+      ui->setComment(var, "Model size and free memory fragmentation");
+      return true;
+    default: return false;
+  }});
+
+  ui->initText(parentVar, "tblCells", nullptr, 32, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setLabel(var, "Table cells");
+      ui->setComment(var, "Refreshed (if all rows were refreshed)");
+      return true;
+    default: return false;
+  }});
+
   #ifdef STARBASE_DEVMODE
 
   ui->initCheckBox(parentVar, "showObsolete", &doShowObsolete, false, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
@@ -68,34 +151,308 @@ void SysModModel::setup() {
     default: return false;
   }});
 
+  ui->initButton(parentVar, "findVarBenchmark", false, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setComment(var, "Time findVar: index vs walking the model");
+      return true;
+    case onChange: {
+      std::vector<const char *> ids;
+      xSemaphoreTake(varIndexMutex, portMAX_DELAY);
+      varIndex.ids(ids);
+      xSemaphoreGive(varIndexMutex);
+
+      JsonObject savedParentVar = modelParentVar; //walkVar and findVar change it
+      unsigned long start = micros();
+      for (const char * id: ids) findVar(id);
+      unsigned long indexTime = micros() - start;
+      start = micros();
+      for (const char * id: ids) walkVar(id, model->as<JsonArray>());
+      unsigned long walkTime = micros() - start;
+      modelParentVar = savedParentVar;
+
+      ppf("dev findVar benchmark %d vars: index %lu µs, walk %lu µs\n", ids.size(), indexTime, walkTime);
+      web->addResponseV(var["id"], "comment", "%d vars: index %lu µs, walk %lu µs", ids.size(), indexTime, walkTime);
+      return true; }
+    default: return false;
+  }});
+
+  ui->initButton(parentVar, "bootBenchmark", false, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setComment(var, "Time reading model.json vs model.mpk");
+      return true;
+    case onChange: {
+      unsigned long jsonTime = 0, snapshotTime = 0;
+      int jsonHeap = 0, snapshotHeap = 0;
+      {
+        JsonDocument doc; //heap, not the model allocator (psram)
+        size_t freeHeap = ESP.getFreeHeap();
+        unsigned long start = millis();
+        if (files->readObjectFromFile("/model.json", &doc)) jsonTime = millis() - start;
+        jsonHeap = freeHeap - ESP.getFreeHeap();
+      }
+      {
+        JsonDocument doc; //heap, not the model allocator (psram)
+        size_t freeHeap = ESP.getFreeHeap();
+        unsigned long start = millis();
+        if (readModelSnapshot(&doc)) snapshotTime = millis() - start;
+        snapshotHeap = freeHeap - ESP.getFreeHeap();
+      }
+      ppf("dev boot benchmark json %lu ms (%d B) mpk %lu ms (%d B)\n", jsonTime, jsonHeap, snapshotTime, snapshotHeap);
+      web->addResponseV(var["id"], "comment", "json %lu ms (%d B) mpk %lu ms (%d B)", jsonTime, jsonHeap, snapshotTime, snapshotHeap);
+      return true; }
+    default: return false;
+  }});
+
   #endif //STARBASE_DEVMODE
 }
 
 void SysModModel::loop20ms() {
 
   if (!cleanUpModelDone) { //do after all setups
+    replayJournalPending(); //before cleanUpModelDone: not journaled again
     cleanUpModelDone = true;
     cleanUpModel();
   }
 
   if (doWriteModel) {
-    ppf("Writing model to /model.json... (serializeConfig)\n");
+    writeModel();
+    doWriteModel = false;
+  }
+}
 
-    // files->writeObjectToFile("/model.json", model);
+void SysModModel::loop1s() {
+  flushJournal();
 
-    cleanUpModel(JsonObject(), false, true);//remove if var["o"] is negative (not cleanedUp) and remove ro values
+  setUIValueV("tblCells", "%d /s (all rows: %d /s)", cellsRefreshed, cellsFullRefresh);
+  cellsRefreshed = 0;
+  cellsFullRefresh = 0;
+}
 
-    StarJson starJson("/model.json", "w"); //open fileName for deserialize
-    starJson.addExclusion("fun");
-    starJson.addExclusion("dash");
-    starJson.addExclusion("o"); //order
-    starJson.addExclusion("p"); //pointers
-    starJson.writeJsonDocToFile(model);
+void SysModModel::dataSizeManager() {
+  if (allocator.nrOfArenas())
+    setUIValueV("mdlMem", "%d B in %d blocks, %d arenas (%d%% fragmented)", allocator.bytes, allocator.blocks, allocator.nrOfArenas(), allocator.fragmentation());
+  else
+    setUIValueV("mdlMem", "%d B in %d blocks (heap %d%% fragmented)", allocator.bytes, allocator.blocks, allocator.fragmentation());
+}
 
-    // print->printJson("Write model", *model); //this shows the model before exclusion
+//slots (2 per object member, 1 per array element) and copied strings: strings shared by vars are counted for each var and
+//  doubles / 64 bit ints using an extra slot are not counted, so an estimate
+size_t SysModModel::varMemoryEstimate(JsonVariantConst variant) {
+  const size_t slotSize = 2 * sizeof(void *); //8 on ESP32
+  const size_t stringHeaderSize = 8; //refcount, length and next of a copied string
+  size_t bytes = 0;
+  if (variant.is<JsonObjectConst>()) {
+    for (JsonPairConst pair: variant.as<JsonObjectConst>()) {
+      bytes += 2 * slotSize + varMemoryEstimate(pair.value());
+      if (!pair.key().isLinked()) bytes += stringHeaderSize + pair.key().size() + 1;
+    }
+  }
+  else if (variant.is<JsonArrayConst>()) {
+    for (JsonVariantConst element: variant.as<JsonArrayConst>())
+      bytes += slotSize + varMemoryEstimate(element);
+  }
+  else if (variant.is<JsonString>()) {
+    JsonString string = variant.as<JsonString>();
+    if (!string.isLinked()) bytes += stringHeaderSize + string.size() + 1;
+  }
+  return bytes;
+}
 
-    doWriteModel = false;
+void SysModModel::writeModel() {
+  ppf("Writing model to /model.json... (serializeConfig)\n");
+
+  // files->writeObjectToFile("/model.json", model);
+
+  cleanUpModel(JsonObject(), false, true);//remove if var["o"] is negative (not cleanedUp) and remove ro values
+
+  //write to temporary files first, so a power cut while writing does not corrupt the model
+  StarJson starJson("/model.json.tmp", "w"); //open fileName for deserialize
+  starJson.addExclusion("fun");
+  starJson.addExclusion("dash");
+  starJson.addExclusion("o"); //order
+  starJson.addExclusion("p"); //pointers
+  starJson.writeJsonDocToFile(model); //closes the file
+
+  uint32_t jsonSize;
+  uint32_t jsonHash = fileHash("/model.json.tmp", &jsonSize); //snapshot is only valid for this model.json
+
+  if (jsonSize == 0) {
+    ppf("writeModel /model.json.tmp not written, model not saved\n");
+    return;
+  }
+
+  ppf("Writing model snapshot to /model.mpk...\n");
+
+  byte header[sizeof(snapshotMagic) + 2 * sizeof(uint32_t)];
+  memcpy(header, snapshotMagic, sizeof(snapshotMagic));
+  memcpy(header + sizeof(snapshotMagic), &jsonSize, sizeof(jsonSize));
+  memcpy(header + sizeof(snapshotMagic) + sizeof(jsonSize), &jsonHash, sizeof(jsonHash));
+
+  StarJson snapshot("/model.mpk.tmp", "w");
+  snapshot.addExclusion("fun");
+  snapshot.addExclusion("dash");
+  snapshot.addExclusion("o"); //order
+  snapshot.addExclusion("p"); //pointers
+  bool snapshotWritten = snapshot.writeMsgPackDocToFile(model, header, sizeof(header));
+  if (!snapshotWritten) {
+    ppf("writeModel /model.mpk not written (unsupported value), boot reads /model.json\n");
+    files->remove("/model.mpk.tmp");
   }
+
+  // print->printJson("Write model", *model); //this shows the model before exclusion
+
+  //after each step boot still results in the same model: old / no snapshot, model.json and journal (replay is idempotent)
+  if (LittleFS.exists("/model.mpk")) files->remove("/model.mpk"); //old snapshot not valid for the new model.json
+  files->rename("/model.json.tmp", "/model.json");
+  if (snapshotWritten) files->rename("/model.mpk.tmp", "/model.mpk");
+  xSemaphoreTake(journalMutex, portMAX_DELAY);
+  journalDoc.clear(); //in the model just written
+  if (LittleFS.exists("/model.jnl")) files->remove("/model.jnl");
+  xSemaphoreGive(journalMutex);
+}
+
+void SysModModel::journalValue(JsonObject var, unsigned8 rowNr) {
+  if (!cleanUpModelDone) return; //values set during setup are defaults or already in the model
+
+  //by id only (also called in the AsyncTCP task): vars which are not saved are skipped in flushJournal
+  char key[64]; //same format as processJson
+  if (rowNr == UINT8_MAX)
+    strlcpy(key, varID(var), sizeof(key));
+  else
+    snprintf(key, sizeof(key), "%s#%d", varID(var), rowNr);
+
+  xSemaphoreTake(journalMutex, portMAX_DELAY);
+  journalDoc[key] = (rowNr == UINT8_MAX)?var["value"]:var["value"][rowNr];
+  xSemaphoreGive(journalMutex);
+}
+
+void SysModModel::varChanged(JsonObject var, unsigned8 rowNr) {
+  if (!varRO(var)) journalValue(var, rowNr);
+  web->modelValueChanged(varID(var));
+
+  if (inBatch()) {
+    for (VarChange &change: *batchChanges)
+      if (change.rowNr == rowNr && varID(change.var) == varID(var)) return; //already recorded (same id pointer is same var)
+    batchChanges->push_back({var, rowNr});
+  }
+  else
+    callVarChangeFun(var, rowNr);
+}
+
+void SysModModel::beginBatch() {
+  if (!batchChanges) batchChanges = new std::vector<VarChange>(); //first batch of this task
+  batchLevel++;
+}
+
+bool SysModModel::inBatch() {
+  return batchLevel > 0;
+}
+
+void SysModModel::commitBatch() {
+  if (!inBatch()) return;
+  if (--batchLevel) return; //nested batch, outer batch commits
+
+  std::vector<VarChange> changes;
+  changes.swap(*batchChanges); //onChange can call setValue, not part of this batch
+  for (VarChange &change: changes)
+    callVarChangeFun(change.var, change.rowNr);
+
+  if (changes.size() > 1)
+    ppf("commitBatch %d changes\n", changes.size());
+  else if (changes.size() == 1)
+    ppf("commitBatch %s\n", varID(changes.front().var));
+}
+
+void SysModModel::flushJournal() {
+  xSemaphoreTake(journalMutex, portMAX_DELAY);
+  if (journalDoc.as<JsonObject>().size()) {
+    File f = files->open("/model.jnl", "a", true);
+    if (f) {
+      for (JsonPair pair: journalDoc.as<JsonObject>()) {
+        char id[64];
+        strlcpy(id, pair.key().c_str(), sizeof(id));
+        char * rowNrC = strchr(id, '#');
+        if (rowNrC) *rowNrC = '\0';
+        JsonObject parentVar = findParentVar(id); //loop task: varIndex not changed meanwhile
+        if (!parentVar.isNull() && parentVar["id"] == "insTbl") continue; //not saved, see cleanUpModel
+
+        f.printf("{\"%s\":", pair.key().c_str());
+        serializeJson(pair.value(), f);
+        f.print("}\n");
+      }
+      if (f.size() > 4096) //compact
+        doWriteModel = true;
+      f.close();
+    }
+    else
+      ppf("flushJournal open /model.jnl failed\n");
+    journalDoc.clear();
+  }
+  xSemaphoreGive(journalMutex);
+}
+
+void SysModModel::replayJournal() {
+  if (!LittleFS.exists("/model.jnl")) return;
+
+  File f = files->open("/model.jnl", "r");
+  if (!f) return;
+
+  unsigned long start = millis();
+  unsigned16 changes = 0;
+  JsonDocument line;
+  while (f.available()) {
+    String text = f.readStringUntil('\n');
+    if (deserializeJson(line, text) || !line.is<JsonObject>()) { //e.g. last line not complete due to power cut
+      ppf("replayJournal invalid line ignored: %s\n", text.c_str());
+      break;
+    }
+    for (JsonPair pair: line.as<JsonObject>()) {
+      char id[64];
+      strlcpy(id, pair.key().c_str(), sizeof(id));
+      unsigned8 rowNr = UINT8_MAX;
+      char * rowNrC = strchr(id, '#');
+      if (rowNrC) {
+        rowNr = atoi(rowNrC + 1);
+        *rowNrC = '\0';
+      }
+
+      JsonObject var = findVar(id);
+      if (var.isNull()) { //var removed, or created after the last compaction: retry after setup of all modules
+        journalPending[pair.key().c_str()] = pair.value(); //copied, line is reused
+        continue;
+      }
+
+      if (rowNr == UINT8_MAX)
+        var["value"] = pair.value();
+      else {
+        if (!var["value"].is<JsonArray>()) var["value"].to<JsonArray>();
+        var["value"][rowNr] = pair.value();
+      }
+      changes++;
+    }
+  }
+  f.close();
+
+  ppf("Replayed %d changes from /model.jnl in %lu ms\n", changes, millis() - start);
+}
+
+void SysModModel::replayJournalPending() {
+  unsigned16 changes = 0;
+  for (JsonPair pair: journalPending.as<JsonObject>()) {
+    char id[64];
+    strlcpy(id, pair.key().c_str(), sizeof(id));
+    unsigned8 rowNr = UINT8_MAX;
+    char * rowNrC = strchr(id, '#');
+    if (rowNrC) {
+      rowNr = atoi(rowNrC + 1);
+      *rowNrC = '\0';
+    }
+    if (findVar(id).isNull()) continue; //var removed
+    setValueJV(id, pair.value(), rowNr); //with onChange, as setup is done already
+    changes++;
+  }
+  if (changes) ppf("Replayed %d changes of new vars from /model.jnl\n", changes);
+  journalPending.clear();
 }
 
 void SysModModel::cleanUpModel(JsonObject parent, bool oPos, bool ro) {
@@ -143,36 +500,77 @@ void SysModModel::cleanUpModel(JsonObject parent, bool oPos, bool ro) {
         cleanUpModel(var, oPos, ro);
     } 
   }
+
+  if (parent.isNull()) { //top level done: vars may have been removed, so rebuild the index
+    varIndexRebuild();
+    web->invalidateModelCache();
+  }
 }
 
 JsonObject SysModModel::findVar(const char * id, JsonArray parent) {
-  JsonArray root;
   // print ->print("findVar %s %s\n", id, parent.isNull()?"root":"n");
-  if (parent.isNull()) {
-    root = model->as<JsonArray>();
-    modelParentVar = JsonObject();
+  if (!parent.isNull()) //search within parent only
+    return walkVar(id, parent);
+
+  //lookup in index, validate as var could be moved or removed
+  VarIndexEntry entry;
+  if (varIndexFind(id, entry)) {
+    modelParentVar = entry.parentVar;
+    return entry.var;
   }
-  else
-    root = parent;
 
-  for (JsonObject var : root) {
-    // if (foundVar.isNull()) {
-      if (var["id"] == id)
-        return var;
-      else if (!var["n"].isNull()) {
-        JsonObject foundVar = findVar(id, var["n"]);
-        if (!foundVar.isNull()) {
-          if (modelParentVar.isNull()) modelParentVar = var;  //only recursive lowest assigns parentVar
-          // ppf("findvar parent of %s is %s\n", id, varID(modelParentVar));
-          return foundVar;
-        }
-      }
-    // }
+  //not in index: walk the model and add to index
+  modelParentVar = JsonObject();
+  JsonObject var = walkVar(id, model->as<JsonArray>());
+  if (!var.isNull())
+    varIndexAdd(var, modelParentVar);
+  return var;
+}
+
+bool SysModModel::varIndexFind(const char * id, VarIndexEntry &entry) {
+  xSemaphoreTake(varIndexMutex, portMAX_DELAY);
+  bool found = varIndex.find(id, entry);
+  xSemaphoreGive(varIndexMutex);
+  return found;
+}
+
+void SysModModel::varIndexAdd(JsonObject var, JsonObject parentVar) {
+  xSemaphoreTake(varIndexMutex, portMAX_DELAY);
+  varIndex.add(var, parentVar);
+  xSemaphoreGive(varIndexMutex);
+}
+
+JsonObject SysModModel::walkVar(const char * id, JsonArray vars, JsonObject parentVar) {
+  for (JsonObject var : vars) {
+    if (var["id"] == id) {
+      modelParentVar = parentVar;
+      return var;
+    }
+    else if (!var["n"].isNull()) {
+      JsonObject foundVar = walkVar(id, var["n"], var);
+      if (!foundVar.isNull())
+        return foundVar;
+    }
   }
   return JsonObject();
 }
 
+void SysModModel::varIndexRebuild(JsonArray vars, JsonObject parentVar) {
+  xSemaphoreTake(varIndexMutex, portMAX_DELAY);
+  if (vars.isNull()) { //root
+    varIndex.clear();
+    vars = model->as<JsonArray>();
+  }
+  varIndex.addAll(vars, parentVar);
+  xSemaphoreGive(varIndexMutex);
+}
+
 JsonObject SysModModel::findParentVar(const char * id, JsonObject parent) {
+  if (parent.isNull()) { //use the index, do not change modelParentVar
+    VarIndexEntry entry;
+    if (varIndexFind(id, entry)) return entry.parentVar;
+  }
+
   JsonArray varArray;
   // print ->print("findParentVar %s %s\n", id, parent.isNull()?"root":"n");
   if (parent.isNull()) {
@@ -225,6 +623,32 @@ void SysModModel::findVars(const char * property, bool value, FindFun fun, JsonA
 //     }
 // }
 
+static void setPointer8(JsonVariant value, int pointer) {*(uint8_t *)pointer = value;}
+static void setPointer16(JsonVariant value, int pointer) {*(uint16_t *)pointer = value;}
+static void setPointerCoord3D(JsonVariant value, int pointer) {*(Coord3D *)pointer = value;}
+
+const VarTypeInfo varTypeInfo[t_count] = {
+  {"appmod", true, nullptr},
+  {"sysmod", true, nullptr},
+  {"usermod", true, nullptr},
+  {"table", true, nullptr},
+  {"text", true, nullptr},
+  {"file", true, nullptr},
+  {"password", true, nullptr},
+  {"number", true, setPointer16},
+  {"pin", true, nullptr},
+  {"progress", true, nullptr},
+  {"coord3D", true, setPointerCoord3D},
+  {"range", true, setPointer8},
+  {"canvas", true, nullptr},
+  {"checkbox", true, setPointer8},
+  {"button", false, nullptr},
+  {"select", true, setPointer8},
+  {"ip", true, nullptr},
+  {"textarea", true, nullptr},
+  {"url", true, nullptr}
+};
+
 bool checkDash(JsonObject var) {
   if (var["dash"])
     return true;
@@ -240,8 +664,13 @@ bool SysModModel::callVarChangeFun(JsonObject var, unsigned8 rowNr, bool init) {
   //not in SysModModel.h as ui->callVarFun cannot be used in SysModModel.h
 
   if (!init) {
-    if (checkDash(var))
-      instances->changedVarsQueue.push_back(var); //tbd: check value arrays / rowNr is working
+    if (checkDash(var)) {
+      bool queued = false;
+      for (JsonObject queuedVar: instances->changedVarsQueue)
+        if (varID(queuedVar) == varID(var)) queued = true; //sent once with its latest value
+      if (!queued)
+        instances->changedVarsQueue.push_back(var); //tbd: check value arrays / rowNr is working
+    }
   }
 
   //if var is bound by pointer, set the pointer value before calling onChange
@@ -256,47 +685,250 @@ bool SysModModel::callVarChangeFun(JsonObject var, unsigned8 rowNr, bool init) {
       pointer = var["p"][rowNr];
     }
 
-    if (var["type"] == "select" || var["type"] == "checkbox" || var["type"] == "range") {
-      uint8_t *valuePointer = (uint8_t *)pointer;
-      if (valuePointer != nullptr) {
-        *valuePointer = value;
-        ppf("pointer set8 %s: v:%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), *valuePointer, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
-      }
+    unsigned8 type = varType(var);
+    if (type < t_count && varTypeInfo[type].setPointer) {
+      if (pointer != 0)
+        varTypeInfo[type].setPointer(value, pointer);
       else
-        ppf("dev pointer set8 %s: v:%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), *valuePointer, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
+        ppf("dev pointer of %s is null (r:%d v:%s)\n", varID(var), rowNr, value.as<String>().c_str());
+    }
+    else
+      ppf("dev pointer of type %s not supported yet\n", varTypeName(var));
+  }
+
+  return ui->callVarFun(var, rowNr, onChange);
+
+  // web->sendResponseObject();
+}  
+
+void TableRefresh::refresh(unsigned8 nrOfRows) {
+  if (tableVar.isNull()) return;
+  if (!web->ws.count()) return; //nobody to show it to, refresh when a client is connected
+
+  //take the marked rows, rows marked meanwhile are refreshed next time (columns are not called under rowsMutex)
+  xSemaphoreTake(rowsMutex, portMAX_DELAY);
+  bool refreshAll = allRows;
+  allRows = false;
+  refreshRows.clear();
+  refreshRows.swap(rows);
+  xSemaphoreGive(rowsMutex);
+  if (!refreshAll && refreshRows.empty()) return;
+
+  unsigned8 nrOfColumns = 0;
+  for (JsonObject childVar: mdl->varChildren(tableVar)) {
+    if (refreshAll)
+      ui->callVarFun(childVar, UINT8_MAX, onSetValue);
+    else
+      for (unsigned8 rowNr: refreshRows)
+        if (rowNr < nrOfRows) ui->callVarFun(childVar, rowNr, onSetValue);
+    nrOfColumns++;
+  }
+
+  mdl->cellsRefreshed += (refreshAll?nrOfRows:refreshRows.size()) * nrOfColumns;
+  mdl->cellsFullRefresh += nrOfRows * nrOfColumns;
+}
+
+//RAM_Allocator: each block starts with a header: size of the block (including header) and used
+struct AllocHeader {
+  uint32_t size;
+  uint32_t used;
+};
+#define allocHeaderSize sizeof(AllocHeader) //8: keeps blocks 8 byte aligned
+
+//lock of the model allocator: the model is also changed outside the loop task (e.g. setValue in async_tcp)
+//  recursive as reallocate allocates and deallocates
+void RAM_Allocator::lock() {if (mutex) xSemaphoreTakeRecursive(mutex, portMAX_DELAY);}
+void RAM_Allocator::unlock() {if (mutex) xSemaphoreGiveRecursive(mutex);}
+
+void* RAM_Allocator::allocate(size_t size) {
+  size_t chunkSize = (size + allocHeaderSize + 7) & ~7;
+  byte * chunk = nullptr;
+  lock();
+
+  #ifdef STARBASE_MODEL_ARENA
+    if (useArena) chunk = arenaAllocate(chunkSize);
+  #endif
+
+  if (!chunk) {
+    if (psramFound()) chunk = (byte *)ps_malloc(chunkSize); // use PSRAM if it exists
+    else              chunk = (byte *)malloc(chunkSize);    // fallback
+    if (!chunk) {unlock(); return nullptr;}
+    ((AllocHeader *)chunk)->size = chunkSize;
+    ((AllocHeader *)chunk)->used = 1;
+  }
+
+  bytes += chunkSize;
+  blocks++;
+  unlock();
+  return chunk + allocHeaderSize;
+}
+
+void RAM_Allocator::deallocate(void* pointer) {
+  if (!pointer) return;
+  byte * chunk = (byte *)pointer - allocHeaderSize;
+  lock();
+  bytes -= ((AllocHeader *)chunk)->size;
+  blocks--;
+
+  #ifdef STARBASE_MODEL_ARENA
+    if (inArena(chunk)) {
+      ((AllocHeader *)chunk)->used = 0; //merged with free neighbours when allocating
+      unlock();
+      return;
     }
-    else if (var["type"] == "number") {
-      uint16_t *valuePointer = (uint16_t *)pointer;
-      if (valuePointer != nullptr) {
-        *valuePointer = value;
-        ppf("pointer set16 %s: v:%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), *valuePointer, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
+  #endif
+
+  unlock();
+  free(chunk);
+}
+
+void* RAM_Allocator::reallocate(void* ptr, size_t new_size) {
+  if (!ptr) return allocate(new_size);
+
+  byte * chunk = (byte *)ptr - allocHeaderSize;
+  size_t chunkSize = (new_size + allocHeaderSize + 7) & ~7;
+  lock();
+  size_t oldSize = ((AllocHeader *)chunk)->size;
+
+  #ifdef STARBASE_MODEL_ARENA
+    if (inArena(chunk)) {
+      void * newPtr = ptr;
+      if (arenaResize(chunk, chunkSize))
+        bytes += ((AllocHeader *)chunk)->size - oldSize;
+      else { //move to a free block (other arena or heap)
+        newPtr = allocate(new_size);
+        if (newPtr) {
+          memcpy(newPtr, ptr, min(oldSize - allocHeaderSize, new_size));
+          deallocate(ptr);
+        }
       }
-      else
-        ppf("dev pointer set16 %s: v:%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), *valuePointer, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
+      unlock();
+      return newPtr;
     }
-    // else if (var["type"] == "text") {
-    //   const char *valuePointer = (const char *)pointer;
-    //   if (valuePointer != nullptr) {
-    //     *valuePointer = value;
-    //     ppf("pointer set16 %s: v:%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), *valuePointer, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
-    //   }
-    //   else
-    //     ppf("dev pointer set16 %s: v:%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), *valuePointer, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
-    // }
-    else if (var["type"] == "coord3D") {
-      Coord3D *valuePointer = (Coord3D *)pointer;
-      if (valuePointer != nullptr) {
-        *valuePointer = value;
-        // ppf("pointer set coord3D %s: v:%d,%d,%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), (*valuePointer).x, (*valuePointer).y, (*valuePointer).z, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
+  #endif
+
+  byte * newChunk;
+  if (psramFound()) newChunk = (byte *)ps_realloc(chunk, chunkSize); // use PSRAM if it exists
+  else              newChunk = (byte *)realloc(chunk, chunkSize);    // fallback
+  if (newChunk) {
+    ((AllocHeader *)newChunk)->size = chunkSize;
+    bytes += chunkSize - oldSize;
+  }
+  unlock();
+  return newChunk?newChunk + allocHeaderSize:nullptr;
+}
+
+void RAM_Allocator::freeBlocks(size_t &freeBytes, size_t &largestFree) {
+  freeBytes = 0;
+  largestFree = 0;
+
+  #ifdef STARBASE_MODEL_ARENA
+    if (arenaCount) {
+      lock();
+      for (forUnsigned8 i = 0; i < arenaCount; i++) {
+        size_t freeRun = 0; //adjacent free chunks
+        for (byte * chunk = arenas[i]; chunk < arenas[i] + STARBASE_MODEL_ARENA; chunk += ((AllocHeader *)chunk)->size) {
+          if (((AllocHeader *)chunk)->used)
+            freeRun = 0;
+          else {
+            freeRun += ((AllocHeader *)chunk)->size;
+            freeBytes += ((AllocHeader *)chunk)->size;
+            largestFree = max(largestFree, freeRun);
+          }
+        }
       }
-      else
-        ppf("dev pointer set coord3D %s: v:%d,%d,%d (p:%p) (r:%d v:%s p:%d)\n", varID(var), (*valuePointer).x, (*valuePointer).y, (*valuePointer).z, valuePointer, rowNr, var["value"].as<String>().c_str(), pointer);
+      unlock();
+      return;
     }
-    else
-      ppf("dev pointer of type %s not supported yet\n", var["type"].as<String>().c_str());
+  #endif
+
+  uint32_t caps = psramFound()?MALLOC_CAP_SPIRAM:MALLOC_CAP_8BIT;
+  freeBytes = heap_caps_get_free_size(caps);
+  largestFree = heap_caps_get_largest_free_block(caps);
+}
+
+#ifdef STARBASE_MODEL_ARENA
+
+bool RAM_Allocator::inArena(byte * chunk) {
+  for (forUnsigned8 i = 0; i < arenaCount; i++)
+    if (chunk >= arenas[i] && chunk < arenas[i] + STARBASE_MODEL_ARENA) return true;
+  return false;
+}
+
+//merge the free chunks after chunk into it
+static void arenaMerge(byte * chunk, byte * arenaEnd) {
+  AllocHeader * header = (AllocHeader *)chunk;
+  while (chunk + header->size < arenaEnd && !((AllocHeader *)(chunk + header->size))->used)
+    header->size += ((AllocHeader *)(chunk + header->size))->size;
+}
+
+//make chunk chunkSize if the rest is big enough for another block
+static void arenaSplit(byte * chunk, size_t chunkSize) {
+  AllocHeader * header = (AllocHeader *)chunk;
+  if (header->size >= chunkSize + 2 * allocHeaderSize) {
+    AllocHeader * rest = (AllocHeader *)(chunk + chunkSize);
+    rest->size = header->size - chunkSize;
+    rest->used = 0;
+    header->size = chunkSize;
   }
+}
 
-  return ui->callVarFun(var, rowNr, onChange);
+byte * RAM_Allocator::arenaAllocate(size_t chunkSize) {
+  if (chunkSize > STARBASE_MODEL_ARENA) return nullptr;
+
+  //first fit
+  for (forUnsigned8 i = 0; i < arenaCount; i++) {
+    byte * arenaEnd = arenas[i] + STARBASE_MODEL_ARENA;
+    for (byte * chunk = arenas[i]; chunk < arenaEnd; chunk += ((AllocHeader *)chunk)->size) {
+      AllocHeader * header = (AllocHeader *)chunk;
+      if (!header->used) {
+        arenaMerge(chunk, arenaEnd);
+        if (header->size >= chunkSize) {
+          arenaSplit(chunk, chunkSize);
+          header->used = 1;
+          return chunk;
+        }
+      }
+    }
+  }
 
-  // web->sendResponseObject();
-}  
\ No newline at end of file
+  //no room: new arena
+  if (arenaCount < sizeof(arenas) / sizeof(arenas[0])) {
+    byte * arena;
+    if (psramFound()) arena = (byte *)ps_malloc(STARBASE_MODEL_ARENA);
+    else              arena = (byte *)malloc(STARBASE_MODEL_ARENA);
+    if (arena) {
+      ppf("RAM_Allocator arena %d of %d B\n", arenaCount, STARBASE_MODEL_ARENA);
+      arenas[arenaCount++] = arena;
+      ((AllocHeader *)arena)->size = STARBASE_MODEL_ARENA;
+      ((AllocHeader *)arena)->used = 0;
+      arenaSplit(arena, chunkSize);
+      ((AllocHeader *)arena)->used = 1;
+      return arena;
+    }
+  }
+
+  return nullptr; //heap
+}
+
+bool RAM_Allocator::arenaResize(byte * chunk, size_t chunkSize) {
+  AllocHeader * header = (AllocHeader *)chunk;
+  if (chunkSize > header->size) { //grow into free chunks after it
+    byte * next = chunk + header->size;
+    for (forUnsigned8 i = 0; i < arenaCount; i++) {
+      byte * arenaEnd = arenas[i] + STARBASE_MODEL_ARENA;
+      if (chunk >= arenas[i] && chunk < arenaEnd) {
+        if (next < arenaEnd && !((AllocHeader *)next)->used) {
+          arenaMerge(next, arenaEnd);
+          if (header->size + ((AllocHeader *)next)->size >= chunkSize)
+            header->size += ((AllocHeader *)next)->size;
+        }
+      }
+    }
+    if (chunkSize > header->size) return false;
+  }
+  arenaSplit(chunk, chunkSize); //shrink, rest becomes free
+  return true;
+}
+
+#endif
@@ -14,6 +14,10 @@
 #include "SysModPrint.h"
 #include "SysModWeb.h"
 #include "SysModules.h" //isConnected
+#include "SysVarIndex.h"
+
+#include <unordered_map>
+#include <algorithm> //std::find
 
 typedef std::function<void(JsonObject)> FindFun;
 typedef std::function<void(JsonObject, size_t)> ChangeFun;
@@ -128,6 +132,46 @@ struct Coord3D {
   }
 };
 
+//var types, stored as number in var["type"], see varTypeInfo for the names used in the UI and model.json
+enum VarTypes
+{
+  t_appmod,
+  t_sysmod,
+  t_usermod,
+  t_table,
+  t_text,
+  t_file,
+  t_password,
+  t_number,
+  t_pin,
+  t_progress,
+  t_coord3D,
+  t_range,
+  t_canvas,
+  t_checkbox,
+  t_button,
+  t_select,
+  t_ip,
+  t_textarea,
+  t_url,
+  t_count
+};
+
+//per var type: name and how a value is written to a var bound by pointer (var["p"])
+struct VarTypeInfo {
+  const char * name;
+  bool hasValue; //a button never gets a value
+  void (*setPointer)(JsonVariant value, int pointer); //nullptr if pointers not supported for this type
+};
+
+extern const VarTypeInfo varTypeInfo[t_count]; //in order of VarTypes
+
+//change recorded during a batch (see beginBatch), onChange is called at commitBatch
+struct VarChange {
+  JsonObject var;
+  unsigned8 rowNr;
+};
+
 //used to sort keys of jsonobjects
 struct ArrayIndexSortValue {
   size_t index;
@@ -159,42 +203,89 @@ namespace ArduinoJson {
 }
 
 // https://arduinojson.org/v7/api/jsondocument/
+//allocator of the model: PSRAM if found, counts the bytes in use (each block has a size header)
+//  STARBASE_MODEL_ARENA (bytes, e.g. 32768): the model is placed in up to 4 arenas of this size (PSRAM if found)
+//    instead of many small heap blocks, so it does not fragment the heap. Heap is used if the arenas are full
 struct RAM_Allocator: ArduinoJson::Allocator {
-  void* allocate(size_t size) override {
-    if (psramFound()) return ps_malloc(size); // use PSRAM if it exists
-    else              return malloc(size);    // fallback
-    // return heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+  size_t bytes = 0; //in use, including headers
+  size_t blocks = 0;
+
+  //useArena: the allocator of the model, its blocks and counters are guarded by a mutex (other allocators are task local)
+  RAM_Allocator(bool useArena = false) {
+    this->useArena = useArena;
+    if (useArena) mutex = xSemaphoreCreateRecursiveMutex();
   }
-  void deallocate(void* pointer) override {
-    free(pointer);
-    // heap_caps_free(pointer);
+
+  void* allocate(size_t size) override;
+  void deallocate(void* pointer) override;
+  void* reallocate(void* ptr, size_t new_size) override;
+
+  //free bytes and largest free block of the arenas (or of the heap used if no arenas)
+  void freeBlocks(size_t &freeBytes, size_t &largestFree);
+  //% of the free memory not in the largest free block
+  unsigned8 fragmentation() {
+    size_t freeBytes, largestFree;
+    freeBlocks(freeBytes, largestFree);
+    return freeBytes?100 - largestFree * 100 / freeBytes:0;
   }
-  void* reallocate(void* ptr, size_t new_size) override {
-    if (psramFound()) return ps_realloc(ptr, new_size); // use PSRAM if it exists
-    else              return realloc(ptr, new_size);    // fallback
-    // return heap_caps_realloc(ptr, new_size, MALLOC_CAP_SPIRAM);
+  unsigned8 nrOfArenas() {
+    #ifdef STARBASE_MODEL_ARENA
+      return arenaCount;
+    #else
+      return 0;
+    #endif
   }
+
+private:
+  bool useArena;
+  SemaphoreHandle_t mutex = nullptr;
+  void lock();
+  void unlock();
+
+  #ifdef STARBASE_MODEL_ARENA
+    byte * arenas[4] = {nullptr, nullptr, nullptr, nullptr};
+    unsigned8 arenaCount = 0;
+    byte * arenaAllocate(size_t chunkSize);
+    bool arenaResize(byte * chunk, size_t chunkSize);
+    bool inArena(byte * chunk);
+  #endif
 };
 
 
+//VarColumnBase: the untyped part of VarColumn (see below), so the model can update the typed array when rows are removed
+class VarColumnBase {
+public:
+  JsonObject var;
+  //row already removed from var["value"] and in the ui (delRow)
+  virtual void rowRemoved(unsigned8 rowNr) = 0;
+};
 
 class SysModModel:public SysModule {
 
 public:
 
-  RAM_Allocator allocator;
+  RAM_Allocator allocator = RAM_Allocator(true); //arena if STARBASE_MODEL_ARENA
   JsonDocument *model = nullptr;
 
   JsonObject modelParentVar;
 
+  SemaphoreHandle_t modelMutex = xSemaphoreCreateMutex(); //held by the loop task while modules run, take it to read the model in other tasks
+
   bool doWriteModel = false;
 
+  unsigned16 cellsRefreshed = 0; //table cells refreshed by TableRefresh, per second
+  unsigned16 cellsFullRefresh = 0; //table cells a refresh of all rows would have done, per second
+
   unsigned8 setValueRowNr = UINT8_MAX;
   unsigned8 getValueRowNr = UINT8_MAX;
 
+  std::vector<VarColumnBase *> varColumns; //attached VarColumns, see varRemoveValuesForRow
+
   SysModModel();
   void setup();
   void loop20ms();
+  void loop1s();
+  void dataSizeManager();
   
   //scan all vars in the model and remove vars where var["o"] is negative or positive, if ro then remove ro values
   void cleanUpModel(JsonObject parent = JsonObject(), bool oPos = true, bool ro = false);
@@ -246,8 +337,8 @@ public:
           // ppf("dev setValue value removed %s %s\n", varID(var), var["oldValue"].as<String>().c_str());
         }
         else {
-          //only print if ! read only
-          if (!varRO(var))
+          //only print if ! read only (in a batch commitBatch prints a summary)
+          if (!varRO(var) && !inBatch())
             ppf("setValue changed %s %s -> %s\n", varID(var), var["oldValue"].as<String>().c_str(), var["value"].as<String>().c_str());
           // else
           //   ppf("setValue changed %s %s\n", varID(var), var["value"].as<String>().c_str());
@@ -277,7 +368,7 @@ public:
           //   ppf("notSame %d %d\n", rowNr, valueArray.size());
           valueArray[rowNr] = value; //if valueArray[<rowNr] not exists it will be created
           // ppf("  assigned %d %d %s\n", rowNr, valueArray.size(), valueArray[rowNr].as<String>().c_str());
-          web->addResponse(var["id"], "value", var["value"]); //send the whole array to UI as response is in format value:<value> !!
+          web->addResponseCell(var["id"], rowNr, valueArray[rowNr]); //only the changed cell
           changed = true;
         }
       }
@@ -286,7 +377,8 @@ public:
       }
     }
 
-    if (changed) callVarChangeFun(var, rowNr);
+    if (changed)
+      varChanged(var, rowNr);
     
     return var;
   }
@@ -345,18 +437,62 @@ public:
       return var["value"];
   }
 
-  //returns the var defined by id (parent to recursively call findVar)
+  //returns the var defined by id (parent to recursively call findVar), uses varIndex if no parent given
   JsonObject findVar(const char * id, JsonArray parent = JsonArray());
   JsonObject findParentVar(const char * id, JsonObject parent = JsonObject());
   void findVars(const char * id, bool value, FindFun fun, JsonArray parent = JsonArray());
 
+  //varIndex (see VarIndex): if not found findVar falls back to walking the model
+  static uint32_t varIdHash(const char * id) {return VarIndex::hash(id);}
+  //a var with the same id in the index is replaced: new var wins from a var with the same id in a different parent
+  void varIndexAdd(JsonObject var, JsonObject parentVar);
+
+  //estimated bytes var and its children use in the model, counted without copying (see mdlTbl)
+  size_t varMemoryEstimate(JsonVariantConst variant);
+
+  //rebuild after vars are removed from the model (removed vars would leave dangling entries)
+  void varIndexRebuild(JsonArray vars = JsonArray(), JsonObject parentVar = JsonObject());
+
   //recursively add values in  a variant, currently not used
   // void varToValues(JsonObject var, JsonArray values);
 
   //sends dash var change to udp (if init),  sets pointer if pointer var and run onChange
   bool callVarChangeFun(JsonObject var, unsigned8 rowNr = UINT8_MAX, bool init = false);
 
+  //add the value of var to the journal, so it is saved without writing the whole model
+  void journalValue(JsonObject var, unsigned8 rowNr = UINT8_MAX);
+
+  //value of var changed: journal it and callVarChangeFun, or record it if in a batch
+  void varChanged(JsonObject var, unsigned8 rowNr = UINT8_MAX);
+
+  //batch of setValues (e.g. a sync message): model and web response are updated directly,
+  //  onChange, pointers and dash (udp) are done at commitBatch, once per var / row in the order of the first change
+  //  can be nested, each task has its own batch (task local), tasks without a batch run setValue as usual
+  void beginBatch();
+  void commitBatch();
+  bool inBatch(); //the current task is in a batch
+
   //pseudo VarObject: public JsonObject functions
+  //var type as VarTypes, t_count if unknown (type as string supported for model.json made by older versions)
+  unsigned8 varType(JsonObject var) {
+    if (var["type"].is<unsigned8>())
+      return min<unsigned8>(var["type"].as<unsigned8>(), t_count); //t_count for out of range numbers too
+    else if (var["type"].is<const char *>())
+      return varTypeFromName(var["type"]);
+    else
+      return t_count;
+  }
+  const char * varTypeName(JsonObject var) {
+    unsigned8 type = varType(var);
+    return type < t_count?varTypeInfo[type].name:"";
+  }
+  static unsigned8 varTypeFromName(const char * name) {
+    for (forUnsigned8 type = 0; type < t_count; type++)
+      if (name && strcmp(varTypeInfo[type].name, name) == 0)
+        return type;
+    return t_count;
+  }
+
   const char * varID(JsonObject var) {return var["id"];}
 
   bool varRO(JsonObject var) {return var["ro"];}
@@ -383,12 +519,15 @@ public:
   }
   void varSetDefaultOrder(JsonObject var, int value) {if (varOrder(var) > -1000) varOrder(var, - value); } //set default order (in range >=1000). Don't use auto generated order as order can be changed in the ui (WIP)
   
-  //recursively remove all value[rowNr] from children of var
+  //recursively remove all value[rowNr] from children of var (and from the VarColumn of a child)
   void varRemoveValuesForRow(JsonObject var, unsigned8 rowNr) {
     for (JsonObject childVar: varChildren(var)) {
       JsonArray valArray = varValArray(childVar);
       if (!valArray.isNull()) {
         valArray.remove(rowNr);
+        for (VarColumnBase *column: varColumns) {
+          if (column->var["id"] == childVar["id"]) column->rowRemoved(rowNr);
+        }
         //recursive
         varRemoveValuesForRow(childVar, rowNr);
       }
@@ -418,6 +557,7 @@ public:
 
       //check if post init added: parent is already >=0
       if (varOrder(var) >= 0) {
+        bool varsRemoved = false;
         for (JsonArray::iterator childVar=varChildren(var).begin(); childVar!=varChildren(var).end(); ++childVar) { //use iterator to make .remove work!!!
         // for (JsonObject &childVar: varChildren(var)) { //use iterator to make .remove work!!!
           JsonArray valArray = varValArray(*childVar);
@@ -441,14 +581,20 @@ public:
             if (allNull) {
               ppf("remove allnulls %s\n", varID(*childVar));
               varChildren(var).remove(childVar);
+              varsRemoved = true;
             }
           }
           else {
             print->printJson("remove non valArray", *childVar);
             varChildren(var).remove(childVar);
+            varsRemoved = true;
           }
 
         }
+        if (varsRemoved) {
+          varIndexRebuild();
+          web->invalidateModelCache();
+        }
       } //if new added
       ppf("varPostDetails post ");
       print->printVar(var);
@@ -483,6 +629,234 @@ private:
   bool cleanUpModelDone = false;
   int varCounter = 1; //start with 1 so it can be negative, see var["o"]
 
+  VarIndex varIndex;
+  //findVar runs in the loop task and in async_tcp (processJson): varIndex only under this mutex
+  SemaphoreHandle_t varIndexMutex = xSemaphoreCreateMutex();
+
+  //copy of the entry of id in varIndex, under varIndexMutex. false if none
+  bool varIndexFind(const char * id, VarIndexEntry &entry);
+
+  //walk the model to find var (no index), sets modelParentVar
+  JsonObject walkVar(const char * id, JsonArray vars, JsonObject parentVar = JsonObject());
+
+  //read /model.mpk if made with the current /model.json, see saveModel
+  bool readModelSnapshot(JsonDocument *doc);
+  //FNV-1a hash of the contents of a file, size of the file in size
+  uint32_t fileHash(const char * path, uint32_t * size);
+
+  //journal (/model.jnl): value changes appended as json lines, flushed each second, compacted into model.json / model.mpk
+  JsonDocument journalDoc; //changes not flushed yet: {"id" or "id#rowNr": value}, latest value wins
+  SemaphoreHandle_t journalMutex = xSemaphoreCreateMutex(); //setValue also runs in the AsyncTCP task
+  void replayJournal();
+  JsonDocument journalPending; //journaled values of vars not in the model at boot (created after the last compaction)
+  void replayJournalPending(); //after setup of all modules, when these vars exist
+  void flushJournal();
+  void writeModel(); //compaction: model.json and model.mpk, then remove the journal
+
+};
+
+extern SysModModel *mdl;
+
+//VarHandle: resolve a var once (e.g. the JsonObject returned by ui->init* in setup) and get / set it without findVar
+//  set: only calls setValue if the value changed, so oldValue, web response, dash and onChange behave as setValue
+//  setUIValueV: UI only (not stored in the model), only sent if the text changed or a ws client connected since
+template <typename Type = const char *>
+class VarHandle {
+public:
+  JsonObject var;
+
+  VarHandle() {}
+  VarHandle(JsonObject var) {this->var = var;}
+  VarHandle& operator=(JsonObject var) {this->var = var; uiValueHash = 0; return *this;}
+
+  bool isNull() {return var.isNull();}
+  const char * id() {return mdl->varID(var);}
+
+  Type get(unsigned8 rowNr = UINT8_MAX) {
+    if (rowNr == UINT8_MAX)
+      return var["value"].as<Type>();
+    else
+      return var["value"][rowNr].as<Type>();
+  }
+
+  //returns true if the value changed
+  bool set(Type value, unsigned8 rowNr = UINT8_MAX) {
+    if (var.isNull()) return false;
+
+    JsonVariant current = (rowNr == UINT8_MAX)?var["value"]:var["value"][rowNr];
+    if (!current.isNull() && valueEquals(current, value))
+      return false;
+
+    mdl->setValue(var, value, rowNr);
+    return true;
+  }
+
+  void setUIValueV(const char * format, ...) {
+    if (var.isNull()) return;
+
+    va_list args;
+    va_start(args, format);
+
+    char value[128];
+    vsnprintf(value, sizeof(value)-1, format, args);
+
+    va_end(args);
+
+    uint32_t hash = SysModModel::varIdHash(value);
+    if (hash == uiValueHash && wsConnects == web->wsConnects) return; //nothing new for the UI
+
+    uiValueHash = hash;
+    wsConnects = web->wsConnects;
+
+    //no print
+    web->addResponse(var["id"], "value", JsonString(value, JsonString::Copied)); //setValue not necessary
+  }
+
+private:
+  uint32_t uiValueHash = 0;
+  unsigned16 wsConnects = 0;
+
+  //strings by content (as<const char *> are pointers), no String copy of the model value
+  template <typename ValueType>
+  static bool valueEquals(JsonVariant current, ValueType value) {return !(current.as<ValueType>() != value);}
+  static bool valueEquals(JsonVariant current, const char * value) {
+    const char * currentValue = current.as<const char *>();
+    return currentValue && value && strcmp(currentValue, value) == 0;
+  }
+  static bool valueEquals(JsonVariant current, const String &value) {return valueEquals(current, value.c_str());}
 };
 
-extern SysModModel *mdl;
\ No newline at end of file
+
+//VarColumn: values of a table column as a typed contiguous array with a dirty bit per row (e.g. instances, files)
+//  set / resize / removeRow only change the array, commit writes the changed rows to var["value"] in one pass,
+//  sends only the changed cells to the UI and calls onChange for them (as setValue)
+//  Type: numbers or String
+template <typename Type>
+class VarColumn: public VarColumnBase {
+public:
+  //attach once (e.g. in onSetValue), starts with the values in the model so unchanged values are not sent again
+  void attach(JsonObject var) {
+    if (!this->var.isNull()) return;
+    this->var = var;
+    mdl->varColumns.push_back(this);
+    values.clear();
+    dirty.clear();
+    if (var["value"].is<JsonArray>()) {
+      for (JsonVariant value: var["value"].as<JsonArray>()) {
+        values.push_back(value.as<Type>());
+        dirty.push_back(false);
+      }
+    }
+  }
+
+  unsigned8 size() {return values.size();}
+  Type get(unsigned8 rowNr) {return values[rowNr];}
+
+  void set(unsigned8 rowNr, Type value) {
+    if (rowNr >= values.size()) resize(rowNr + 1);
+    if (values[rowNr] != value) {
+      values[rowNr] = value;
+      dirty[rowNr] = true;
+    }
+  }
+
+  //new rows are dirty, removed rows make commit send the whole column
+  void resize(unsigned8 nrOfRows) {
+    if (nrOfRows < values.size()) rowsRemoved = true;
+    values.resize(nrOfRows);
+    dirty.resize(nrOfRows, true);
+  }
+
+  void removeRow(unsigned8 rowNr) {
+    if (rowNr >= values.size()) return;
+    values.erase(values.begin() + rowNr);
+    dirty.erase(dirty.begin() + rowNr);
+    rowsRemoved = true;
+  }
+
+  void rowRemoved(unsigned8 rowNr) override {
+    if (rowNr >= values.size()) return;
+    values.erase(values.begin() + rowNr);
+    dirty.erase(dirty.begin() + rowNr);
+  }
+
+  void commit() {
+    if (var.isNull()) return;
+
+    JsonArray valArray = var["value"].is<JsonArray>()?var["value"].as<JsonArray>():var["value"].to<JsonArray>();
+
+    if (rowsRemoved) { //rows shifted: rewrite and send the whole column
+      valArray.clear();
+      for (const Type &value: values) //const &: also std::vector<bool>
+        valArray.add(value);
+      web->addResponse(var["id"], "value", valArray);
+      rowsRemoved = false;
+    }
+    else {
+      unsigned8 rowNr = 0;
+      for (JsonVariant element: valArray) { //iterate, no lookup by index
+        if (rowNr >= values.size()) break;
+        if (dirty[rowNr]) {
+          element.set(get(rowNr));
+          web->addResponseCell(var["id"], rowNr, element);
+        }
+        rowNr++;
+      }
+      for (; rowNr < values.size(); rowNr++) { //new rows
+        JsonVariant element = valArray.add<JsonVariant>();
+        element.set(get(rowNr));
+        web->addResponseCell(var["id"], rowNr, element);
+      }
+    }
+
+    mdl->beginBatch(); //onChange and dash once per changed row, after all rows are set
+    for (forUnsigned8 rowNr = 0; rowNr < dirty.size(); rowNr++) {
+      if (dirty[rowNr]) {
+        dirty[rowNr] = false;
+        mdl->varChanged(var, rowNr);
+      }
+    }
+    mdl->commitBatch();
+  }
+
+private:
+  std::vector<Type> values;
+  std::vector<bool> dirty;
+  bool rowsRemoved = false;
+};
+
+
+//TableRefresh: refresh only the rows of a table of which the source changed (instead of onSetValue on all columns for all rows)
+//  rowChanged: mark a row, UINT8_MAX: all rows (e.g. rows added, removed or sorted)
+//  refresh: onSetValue of each column for the marked rows, only if a ui client is connected (rows stay marked until then)
+//  columns should only refresh the rowNr they are called with (UINT8_MAX: all rows)
+//  rowChanged can be called from any task (e.g. async_tcp), refresh runs in the loop task
+class TableRefresh {
+public:
+  void attach(JsonObject tableVar) {this->tableVar = tableVar;}
+
+  void rowChanged(unsigned8 rowNr = UINT8_MAX) {
+    xSemaphoreTake(rowsMutex, portMAX_DELAY);
+    if (rowNr == UINT8_MAX)
+      allRows = true;
+    else if (std::find(rows.begin(), rows.end(), rowNr) == rows.end())
+      rows.push_back(rowNr);
+    xSemaphoreGive(rowsMutex);
+  }
+
+  bool isChanged() {
+    xSemaphoreTake(rowsMutex, portMAX_DELAY);
+    bool changed = allRows || rows.size();
+    xSemaphoreGive(rowsMutex);
+    return changed;
+  }
+
+  void refresh(unsigned8 nrOfRows); //in SysModModel.cpp as ui->callVarFun is needed
+
+private:
+  JsonObject tableVar;
+  bool allRows = false;
+  std::vector<unsigned8> rows;
+  SemaphoreHandle_t rowsMutex = xSemaphoreCreateMutex(); //allRows and rows
+  std::vector<unsigned8> refreshRows; //rows taken by refresh (loop task only), swapped with rows to keep both capacities
+};
@@ -32,11 +32,15 @@ void SysModPins::setup() {
       return true; }
     default: return false;
   }});
+  pinTblRefresh.attach(tableVar);
 
   ui->initPin(tableVar, "pinNr", UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
-      for (forUnsigned8 rowNr = 0; rowNr < getNrOfAllocatedPins(); rowNr++)
-        mdl->setValue(var, getPinNr(rowNr), rowNr);
+      pinNrColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < getNrOfAllocatedPins() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        pinNrColumn.set(rowNrL, getPinNr(rowNrL));
+      if (rowNr == UINT8_MAX) pinNrColumn.resize(getNrOfAllocatedPins()); //remove rows of deallocated pins
+      pinNrColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Pin");
@@ -46,8 +50,11 @@ void SysModPins::setup() {
 
   ui->initText(tableVar, "pinOwner", nullptr, 32, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
-      for (forUnsigned8 rowNr = 0; rowNr < getNrOfAllocatedPins(); rowNr++)
-        mdl->setValue(var, JsonString(getNthAllocatedPinObject(rowNr).owner, JsonString::Copied), rowNr);
+      pinOwnerColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < getNrOfAllocatedPins() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        pinOwnerColumn.set(rowNrL, getNthAllocatedPinObject(rowNrL).owner);
+      if (rowNr == UINT8_MAX) pinOwnerColumn.resize(getNrOfAllocatedPins());
+      pinOwnerColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Owner");
@@ -57,10 +64,13 @@ void SysModPins::setup() {
 
   ui->initText(tableVar, "pinDetails", nullptr, 256, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
-      for (forUnsigned8 rowNr = 0; rowNr < getNrOfAllocatedPins(); rowNr++) {
-        // ppf("pinDetails[%d] d:%s\n", rowNr, getNthAllocatedPinObject(rowNr).details);
-        mdl->setValue(var, JsonString(getNthAllocatedPinObject(rowNr).details, JsonString::Copied), rowNr);
+      pinDetailsColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < getNrOfAllocatedPins() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
+        // ppf("pinDetails[%d] d:%s\n", rowNrL, getNthAllocatedPinObject(rowNrL).details);
+        pinDetailsColumn.set(rowNrL, getNthAllocatedPinObject(rowNrL).details);
       }
+      if (rowNr == UINT8_MAX) pinDetailsColumn.resize(getNrOfAllocatedPins());
+      pinDetailsColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Details");
@@ -68,7 +78,9 @@ void SysModPins::setup() {
     default: return false;
   }});
 
-  ui->initCanvas(parentVar, "board", UINT16_MAX, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  boardChannel = web->addChannel("board", 10); //only send to clients viewing the board
+
+  ui->initCanvas(parentVar, "board", UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "Pin viewer");
       ui->setComment(var, "🚧");
@@ -76,21 +88,14 @@ void SysModPins::setup() {
     case onLoop:
       var["interval"] = 100; //every 100 ms
 
-      web->sendDataWs([](AsyncWebSocketMessageBuffer * wsBuf) {
-        byte* buffer;
-
-        buffer = wsBuf->get();
-
+      web->sendChannel(boardChannel, [](byte * buffer) {
         // send pins to clients
         for (size_t pinNr = 0; pinNr < NUM_DIGITAL_PINS; pinNr++)
         {
           buffer[pinNr+5] = random(8);// digitalRead(pinNr) * 255; // is only 0 or 1
         }
         // ppf("\n");
-        //new values
-        buffer[0] = 0; //userFun id
-
-      }, NUM_DIGITAL_PINS + 5, true);
+      }, NUM_DIGITAL_PINS + 5);
       return true;
 
     default: return false;
@@ -121,12 +126,7 @@ void SysModPins::setup() {
 
 void SysModPins::loop20ms() {
 
-  if (pinsChanged) {
-    pinsChanged = false;
-
-    for (JsonObject childVar: mdl->varChildren("pinTbl"))
-      ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP)
-  }
+  pinTblRefresh.refresh(getNrOfAllocatedPins());
 }
 
 void SysModPins::allocatePin(unsigned8 pinNr, const char * owner, const char * details) {
@@ -135,9 +135,17 @@ void SysModPins::allocatePin(unsigned8 pinNr, const char * owner, const char * d
     if (strcmp(pinObjects[pinNr].owner, "") != 0 && strcmp(pinObjects[pinNr].owner, owner) != 0)
       ppf("allocatePin %d: not owner %s!=%s", pinNr, owner, pinObjects[pinNr].owner);
     else {
+      bool newRow = strcmp(pinObjects[pinNr].owner, "") == 0;
       strncpy(pinObjects[pinNr].owner, owner, sizeof(PinObject::owner)-1);  
       strncpy(pinObjects[pinNr].details, details, sizeof(PinObject::details)-1);  
-      pinsChanged = true;
+      if (newRow)
+        pinTblRefresh.rowChanged(); //rows after this pin shift
+      else { //only the details of this pin
+        stackUnsigned8 rowNr = 0;
+        for (forUnsigned8 pinNrL = 0; pinNrL < pinNr; pinNrL++)
+          if (strcmp(pinObjects[pinNrL].owner, "") != 0) rowNr++;
+        pinTblRefresh.rowChanged(rowNr);
+      }
     }
   }
 }
@@ -150,7 +158,7 @@ void SysModPins::deallocatePin(unsigned8 pinNr, const char * owner) {
     else {
       strcpy(pinObjects[pinNr].owner, "");  
       strcpy(pinObjects[pinNr].details, "");  
-      pinsChanged = true;
+      pinTblRefresh.rowChanged(); //rows after this pin shift
     }
   }
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #pragma once
 #include "SysModule.h"
 #include "SysModPrint.h"
+#include "SysModModel.h"
 
 #include "Wire.h" //for I2S
 
@@ -78,8 +79,6 @@ public:
     return UINT8_MAX;
   }
 
-  bool pinsChanged = false; //update pins table if pins changed
-
   uint8_t getPinType(uint8_t pinNr) {
     uint8_t pinType;
     if (digitalPinIsValid(pinNr)) {
@@ -124,6 +123,14 @@ public:
     ppf("initI2S Wire begin %s\n", success?"success":"failure");
     return success;
   }
+
+private:
+  TableRefresh pinTblRefresh;
+  VarColumn<unsigned8> pinNrColumn;
+  VarColumn<String> pinOwnerColumn;
+  VarColumn<String> pinDetailsColumn;
+  unsigned8 boardChannel = UINT8_MAX; //pin viewer stream
+
 };
 
 extern SysModPins *pinsM;
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "SysModSystem.h"
 
 SysModPrint::SysModPrint() :SysModule("Print") {
+  loopTaskHandle = xTaskGetCurrentTaskHandle(); //created in setup() of the loopTask
 
 #if ARDUINO_USB_CDC_ON_BOOT || !defined(CONFIG_IDF_TARGET_ESP32S2)
   Serial.begin(115200);
@@ -57,7 +58,7 @@ void SysModPrint::setup() {
   parentVar = ui->initSysMod(parentVar, name, 2302);
 
   //default to Serial
-  ui->initSelect(parentVar, "pOut", 1, false, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  ui->initSelect(parentVar, "pOut", &pOut, false, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
     {
       ui->setLabel(var, "Output");
@@ -85,15 +86,11 @@ void SysModPrint::printf(const char * format, ...) {
 
   va_start(args, format);
 
-  unsigned8 pOut = 1; //default serial
   char buffer[512]; //this is a lot for the stack - move to heap?
   vsnprintf(buffer, sizeof(buffer)-1, format, args);
   bool toSerial = false;
   
   if (mdls->isConnected) {
-    if (mdl->model)
-      pOut = mdl->getValue("pOut");
-
     if (pOut == 1) {
       toSerial = true;
     }
@@ -114,7 +111,7 @@ void SysModPrint::printf(const char * format, ...) {
     toSerial = true;
 
   if (toSerial) {
-    Serial.print(strncmp(pcTaskGetTaskName(NULL), "loopTask", 8) == 0?"":"α"); //looptask λ/ asyncTCP task α
+    Serial.print(xTaskGetCurrentTaskHandle() == loopTaskHandle?"":"α"); //looptask λ/ asyncTCP task α
     Serial.print(buffer);
   }
 
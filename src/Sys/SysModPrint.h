@@ -42,6 +42,8 @@ public:
 
 private:
   bool setupsDone = false;
+  unsigned8 pOut = 1; //value of the pOut var (default serial), set by the model: printf in other tasks does not read the model
+  TaskHandle_t loopTaskHandle = nullptr;
 };
 
 extern SysModPrint *print;
\ No newline at end of file
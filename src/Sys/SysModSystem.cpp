@@ -15,6 +15,7 @@
 #include "SysModWeb.h"
 #include "SysModModel.h"
 #include "SysModNetwork.h"
+#include "SysModules.h"
 #include "User/UserModMDNS.h"
 
 // #include <Esp.h>
@@ -34,7 +35,9 @@
   #include <rom/rtc.h>
 #endif
 
-SysModSystem::SysModSystem() :SysModule("System") {};
+SysModSystem::SysModSystem() :SysModule("System") {
+  loopIdle = true; //loop() counts and sets now when the main loop runs, no need to keep it running
+};
 
 void SysModSystem::setup() {
   SysModule::setup();
@@ -56,21 +59,21 @@ void SysModSystem::setup() {
     default: return false;
   }});
 
-  ui->initText(parentVar, "upTime", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  upTimeVar = ui->initText(parentVar, "upTime", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setComment(var, "Uptime of board");
       return true;
     default: return false;
   }});
 
-  ui->initNumber(parentVar, "now", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  nowVar = ui->initNumber(parentVar, "now", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "now");
       return true;
     default: return false;
   }});
 
-  ui->initNumber(parentVar, "timeBase", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  timeBaseVar = ui->initNumber(parentVar, "timeBase", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "TimeBase");
       return true;
@@ -92,7 +95,77 @@ void SysModSystem::setup() {
     default: return false;
   }});
 
-  ui->initText(parentVar, "loops", nullptr, 16, true);
+  loopsVar = ui->initText(parentVar, "loops", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setComment(var, "Runs of the main loop, it sleeps until a hook is due");
+      return true;
+    default: return false;
+  }});
+
+  //timing of the periodic hooks of the main loop (LoopScheduler)
+  JsonObject tableVar = ui->initTable(parentVar, "loopTbl", nullptr, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setLabel(var, "Loop intervals");
+      ui->setComment(var, "Calls per interval between calls, in % of the hook interval (main loop and module tasks)");
+      return true;
+    default: return false;
+  }});
+
+  ui->initText(tableVar, "loopIvl", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onSetValue:
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < 8 && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
+        char text[16];
+        snprintf(text, sizeof(text), "%s %d%%", rowNrL < 7?"≤":">", LoopScheduler::intervalPercent[rowNrL < 7?rowNrL:6]);
+        mdl->setValue(var, JsonString(text, JsonString::Copied), rowNrL);
+      }
+      return true;
+    case onUI:
+      ui->setLabel(var, "Interval");
+      return true;
+    default: return false;
+  }});
+
+  for (forUnsigned8 hook = h_loop20ms; hook <= h_loop10s; hook++) {
+    char id[16];
+    snprintf(id, sizeof(id), "%sCnt", LoopScheduler::hookNames[hook]); //e.g. loop20msCnt
+    ui->initNumber(tableVar, id, UINT16_MAX, 0, (unsigned long)-1, true, [hook](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+      case onSetValue: {
+        LoopScheduler::HookTiming timing = mdls->hookTiming(hook); //main loop and module tasks
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < 8 && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+          mdl->setValue(var, timing.histogram[rowNrL], rowNrL);
+        return true; }
+      case onUI:
+        ui->setLabel(var, LoopScheduler::hookNames[hook]);
+        return true;
+      default: return false;
+    }});
+  }
+
+  missedVar = ui->initText(parentVar, "loopMissed", nullptr, 32, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setLabel(var, "Missed deadlines");
+      ui->setComment(var, "Called a whole interval or more late");
+      return true;
+    default: return false;
+  }});
+
+  overrunVar = ui->initText(parentVar, "loopOverrun", nullptr, 32, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setLabel(var, "Overruns");
+      ui->setComment(var, "Hook calls > 20 ms, last one");
+      return true;
+    default: return false;
+  }});
+
+  ui->initButton(parentVar, "loopReset", false, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setLabel(var, "Reset intervals");
+      return true;
+    case onChange:
+      mdls->runInLoop([]() {mdls->resetTiming();}); //onChange can run in async_tcp, the timings are written by the loop (and module tasks)
+      return true;
+    default: return false;
+  }});
 
   print->fFormat(chipInfo, sizeof(chipInfo)-1, "%s %s (%d.%d.%d) c#:%d %d mHz f:%d KB %d mHz %d", ESP.getChipModel(), ESP.getSdkVersion(), ESP_ARDUINO_VERSION_MAJOR, ESP_ARDUINO_VERSION_MINOR, ESP_ARDUINO_VERSION_PATCH, ESP.getChipCores(), ESP.getCpuFreqMHz(), ESP.getFlashChipSize()/1024, ESP.getFlashChipSpeed()/1000000, ESP.getFlashChipMode());
   ui->initText(parentVar, "chip", chipInfo, 16, true);
@@ -136,6 +209,26 @@ void SysModSystem::setup() {
     default: return false;
   }});
 
+  //modules running in a task of their own (runInTask), task created after setup
+  for (forUnsigned8 taskNr = 0; taskNr < mdls->taskModules.size(); taskNr++) {
+    SysModule * module = mdls->taskModules[taskNr];
+    char id[16];
+    snprintf(id, sizeof(id), "taskStack%d", taskNr);
+    ui->initProgress(parentVar, id, 0, 0, module->taskStack, true, [module](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+      case onUI: {
+        char label[32];
+        snprintf(label, sizeof(label), "%s stack", module->name);
+        ui->setLabel(var, label);
+        return true; }
+      case onChange:
+        var["max"] = module->taskStack;
+        if (module->taskHandle)
+          web->addResponseV(var["id"], "comment", "%d of %d B", uxTaskGetStackHighWaterMark(module->taskHandle), module->taskStack);
+        return true;
+      default: return false;
+    }});
+  }
+
   ui->initSelect(parentVar, "reset0", (int)rtc_get_reset_reason(0), true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "Reset 0");
@@ -216,10 +309,21 @@ void SysModSystem::loop() {
 }
 
 void SysModSystem::loop1s() {
-  mdl->setUIValueV("upTime", "%lu s", millis()/1000);
-  mdl->setUIValueV("now", "%lu s", now/1000);
-  mdl->setUIValueV("timeBase", "%lu s", (now<millis())? - (UINT32_MAX - timebase)/1000:timebase/1000);
-  mdl->setUIValueV("loops", "%lu /s", loopCounter);
+  upTimeVar.setUIValueV("%lu s", millis()/1000);
+  nowVar.setUIValueV("%lu s", now/1000);
+  timeBaseVar.setUIValueV("%lu s", (now<millis())? - (UINT32_MAX - timebase)/1000:timebase/1000);
+  loopsVar.setUIValueV("%lu /s", loopCounter);
+
+  missedVar.setUIValueV("20ms: %u 1s: %u 10s: %u", mdls->hookTiming(h_loop20ms).missed, mdls->hookTiming(h_loop1s).missed, mdls->hookTiming(h_loop10s).missed);
+  unsigned32 overruns;
+  LoopScheduler * overrunScheduler = mdls->lastOverrun(overruns);
+  if (overrunScheduler)
+    overrunVar.setUIValueV("%u, %s %s %lu ms", overruns, overrunScheduler->overrunModule, LoopScheduler::hookNames[overrunScheduler->overrunHook], overrunScheduler->overrunMicros / 1000);
+  else
+    overrunVar.setUIValueV("0");
+  if (web->ws.count()) //stream the histogram to the UI (only changed cells are sent)
+    for (JsonObject childVar: mdl->varChildren("loopTbl"))
+      ui->callVarFun(childVar, UINT8_MAX, onSetValue);
 
   loopCounter = 0;
 }
@@ -227,6 +331,14 @@ void SysModSystem::loop10s() {
   mdl->setValue("heap", (ESP.getHeapSize()-ESP.getFreeHeap()) / 1000);
   mdl->setValue("mainStack", sysTools_get_arduino_maxStackUsage());
   mdl->setValue("tcpStack", sysTools_get_webserver_maxStackUsage());
+  for (forUnsigned8 taskNr = 0; taskNr < mdls->taskModules.size(); taskNr++) {
+    TaskHandle_t taskHandle = mdls->taskModules[taskNr]->taskHandle;
+    if (taskHandle) {
+      char id[16];
+      snprintf(id, sizeof(id), "taskStack%d", taskNr);
+      mdl->setValue(id, uxTaskGetStackHighWaterMark(taskHandle));
+    }
+  }
 
   if (psramFound()) {
     mdl->setValue("psram", (ESP.getPsramSize()-ESP.getFreePsram()) / 1000);
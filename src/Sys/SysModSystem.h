@@ -12,6 +12,7 @@
 #pragma once
 
 #include "SysModule.h"
+#include "SysModModel.h"
 #include "dependencies/Toki.h"
 
 class SysModSystem:public SysModule {
@@ -65,6 +66,13 @@ public:
 private:
   unsigned long loopCounter = 0;
 
+  VarHandle<> upTimeVar;
+  VarHandle<> nowVar;
+  VarHandle<> timeBaseVar;
+  VarHandle<> loopsVar;
+  VarHandle<> missedVar;
+  VarHandle<> overrunVar;
+
   void addResetReasonsSelect(JsonArray select);
   void addRestartReasonsSelect(JsonArray select);
 
@@ -74,7 +74,12 @@ void SysModUI::loop1s() {
     varLoop.counter = 0;
 }
 
-JsonObject SysModUI::initVar(JsonObject parent, const char * id, const char * type, bool readOnly, VarFun varFun) {
+JsonObject SysModUI::initVar(JsonObject parent, const char * id, unsigned8 type, bool readOnly, VarFun varFun) {
+  if (type >= t_count) {
+    ppf("initVar %s unknown type %d\n", id, type);
+    return JsonObject();
+  }
+
   JsonObject var = mdl->findVar(id); //sets the existing modelParentVar
   const char * modelParentId = mdl->modelParentVar["id"];
   const char * parentId = parent["id"];
@@ -85,9 +90,12 @@ JsonObject SysModUI::initVar(JsonObject parent, const char * id, const char * ty
     ppf("initVar parents not equal %s: %s != %s\n", id, modelParentId, parentId);
   }
 
+  bool structureChanged = false; //model cache of the ui (see invalidateModelCache), value changes go through modelValueChanged
+
   //create new var
   if (differentParents || var.isNull()) {
-    ppf("initVar new %s var: %s->%s\n", type, parentId?parentId:"", id); //parentId not null otherwise crash
+    structureChanged = true;
+    ppf("initVar new %s var: %s->%s\n", varTypeInfo[type].name, parentId?parentId:"", id); //parentId not null otherwise crash
     if (parent.isNull()) {
       JsonArray vars = mdl->model->as<JsonArray>();
       var = vars.add<JsonObject>();
@@ -97,20 +105,27 @@ JsonObject SysModUI::initVar(JsonObject parent, const char * id, const char * ty
       // serializeJson(model, Serial);Serial.println();
     }
     var["id"] = JsonString(id, JsonString::Copied);
+    mdl->varIndexAdd(var, parent); //new var wins from a var with the same id in a different parent
   }
   // else {
   //   ppf("initVar Var %s->%s already defined\n", modelParentId, id);
   // }
 
   if (!var.isNull()) {
-    if (var["type"].isNull() || var["type"] != type) {
-      var["type"] = JsonString(type, JsonString::Copied);
+    if (var["type"].isNull() || var["type"] != type) { //also replaces type names of older model.json
+      var["type"] = type;
+      structureChanged = true;
       // print->printJson("initVar set type", var);
     }
 
-    if (var["ro"].isNull() || mdl->varRO(var) != readOnly) mdl->varRO(var, readOnly);
+    if (var["ro"].isNull() || mdl->varRO(var) != readOnly) {
+      mdl->varRO(var, readOnly);
+      structureChanged = true;
+    }
 
+    int order = mdl->varOrder(var);
     mdl->varInitOrder(parent, var);
+    if (!structureChanged && mdl->varOrder(var) != order) web->modelValueChanged(id); //only the module of the var is serialized again
 
     //if varFun, add it to the list
     if (varFun) {
@@ -139,12 +154,15 @@ JsonObject SysModUI::initVar(JsonObject parent, const char * id, const char * ty
     }
   }
   else
-    ppf("initVar could not find or create var %s with %s\n", id, type);
+    ppf("initVar could not find or create var %s with %s\n", id, varTypeInfo[type].name); //type < t_count checked above
+
+  if (structureChanged) web->invalidateModelCache(); //var added, type or readonly changed
 
   return var;
 }
 
-void SysModUI::processJson(JsonVariant json) {
+bool SysModUI::processJson(JsonVariant json) {
+  bool success = true;
   if (json.is<JsonObject>()) //should be
   {
      //varFun adds object elements to json which would be processed in the for loop. So we freeze the original pairs in a vector and loop on this
@@ -174,6 +192,7 @@ void SysModUI::processJson(JsonVariant json) {
           JsonObject var = mdl->findVar(command["id"]);
           stackUnsigned8 rowNr = command["rowNr"];
           ppf("processJson %s - %s[%d]\n", key, mdl->varID(var), rowNr);
+          if (var.isNull()) success = false;
 
           //first remove the deleted row both on server and on client(s)
           if (pair.key() == "delRow") {
@@ -186,6 +205,8 @@ void SysModUI::processJson(JsonVariant json) {
             web->sendResponseObject(); //async response
           }
         }
+        else
+          success = false;
         json.remove(key); //key processed we don't need the key in the response
       }
       else if (pair.key() == "onUI") { //JsonString can do ==
@@ -197,11 +218,15 @@ void SysModUI::processJson(JsonVariant json) {
               callVarFun(var, UINT8_MAX, onUI);
               //sendDataWs done in caller of processJson
             }
-            else
+            else {
               ppf("dev processJson Command %s var %s not found\n", key, varInArray.as<String>().c_str());
+              success = false;
+            }
           }
-        } else
+        } else {
           ppf("dev processJson value not array? %s %s\n", key, value.as<String>().c_str());
+          success = false;
+        }
         json.remove(key); //key processed we don't need the key in the response
       } 
       else if (!value.isNull()) { // {"varid": {"value":value}} or {"varid": value}
@@ -230,7 +255,7 @@ void SysModUI::processJson(JsonVariant json) {
         if (!var.isNull())
         {
           //a button never sets the value
-          if (var["type"] == "button") { //button always
+          if (mdl->varType(var) == t_button) { //button always
             mdl->callVarChangeFun(var, rowNr);
             if (rowNr != UINT8_MAX) web->getResponseObject()[mdl->varID(var)]["rowNr"] = rowNr;
           }
@@ -239,12 +264,18 @@ void SysModUI::processJson(JsonVariant json) {
           }
           // json.remove(key); //key / var["id"] processed we don't need the key in the response
         }
-        else
+        else {
           ppf("dev Object %s[%d] not found\n", key, rowNr);
+          success = false;
+        }
       } 
       else {
         ppf("dev processJson command not recognized k:%s v:%s\n", key, value.as<String>().c_str());
+        success = false;
       }
     } //for json pairs
   }
+  else
+    success = false;
+  return success;
 }
\ No newline at end of file
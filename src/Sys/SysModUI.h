@@ -50,118 +50,119 @@ public:
 
   //order: order%4 determines the column (WIP)
   JsonObject initAppMod(JsonObject parent, const char * id, int order = 0) {
-    JsonObject var = initVarAndUpdate<const char *>(parent, id, "appmod", (const char *)nullptr);
+    JsonObject var = initVarAndUpdate<const char *>(parent, id, t_appmod, (const char *)nullptr);
     if (order) mdl->varSetDefaultOrder(var, order + 1000);
     return var;
   }
   JsonObject initSysMod(JsonObject parent, const char * id, int order = 0) {
-    JsonObject var = initVarAndUpdate<const char *>(parent, id, "sysmod", (const char *)nullptr);
+    JsonObject var = initVarAndUpdate<const char *>(parent, id, t_sysmod, (const char *)nullptr);
     if (order) mdl->varSetDefaultOrder(var, order + 1000);
     return var;
   }
   JsonObject initUserMod(JsonObject parent, const char * id, int order = 0) {
-    JsonObject var = initVarAndUpdate<const char *>(parent, id, "usermod", (const char *)nullptr);
+    JsonObject var = initVarAndUpdate<const char *>(parent, id, t_usermod, (const char *)nullptr);
     if (order) mdl->varSetDefaultOrder(var, order + 1000);
     return var;
   }
 
   JsonObject initTable(JsonObject parent, const char * id, const char * value = nullptr, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<const char *>(parent, id, "table", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<const char *>(parent, id, t_table, value, 0, 0, readOnly, varFun);
   }
 
   JsonObject initText(JsonObject parent, const char * id, const char * value = nullptr, unsigned16 max = 32, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<const char *>(parent, id, "text", value, 0, max, readOnly, varFun);
+    return initVarAndUpdate<const char *>(parent, id, t_text, value, 0, max, readOnly, varFun);
   }
 
   JsonObject initFile(JsonObject parent, const char * id, const char * value = nullptr, unsigned16 max = 32, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<const char *>(parent, id, "file", value, 0, max, readOnly, varFun);
+    return initVarAndUpdate<const char *>(parent, id, t_file, value, 0, max, readOnly, varFun);
   }
   JsonObject initPassword(JsonObject parent, const char * id, const char * value = nullptr, unsigned8 max = 32, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<const char *>(parent, id, "password", value, 0, max, readOnly, varFun);
+    return initVarAndUpdate<const char *>(parent, id, t_password, value, 0, max, readOnly, varFun);
   }
 
   JsonObject initNumber(JsonObject parent, const char * id, int value = UINT16_MAX, int min = 0, int max = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "number", value, min, max, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_number, value, min, max, readOnly, varFun);
   }
   //init a number using referenced value
   JsonObject initNumber(JsonObject parent, const char * id, uint16_t * value = nullptr, int min = 0, int max = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<uint16_t>(parent, id, "number", value, min, max, readOnly, varFun);
+    return initVarAndUpdate<uint16_t>(parent, id, t_number, value, min, max, readOnly, varFun);
   }
 
   JsonObject initPin(JsonObject parent, const char * id, int value = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "pin", value, 0, NUM_DIGITAL_PINS, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_pin, value, 0, NUM_DIGITAL_PINS, readOnly, varFun);
   }
 
   JsonObject initProgress(JsonObject parent, const char * id, int value = UINT16_MAX, int min = 0, int max = 255, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "progress", value, min, max, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_progress, value, min, max, readOnly, varFun);
   }
 
   JsonObject initCoord3D(JsonObject parent, const char * id, Coord3D value = {UINT16_MAX, UINT16_MAX, UINT16_MAX}, int min = 0, int max = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<Coord3D>(parent, id, "coord3D", value, min, max, readOnly, varFun);
+    return initVarAndUpdate<Coord3D>(parent, id, t_coord3D, value, min, max, readOnly, varFun);
   }
   //init a Coord3D using referenced value
   JsonObject initCoord3D(JsonObject parent, const char * id, Coord3D *value = nullptr, int min = 0, int max = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<Coord3D>(parent, id, "coord3D", value, min, max, readOnly, varFun);
+    return initVarAndUpdate<Coord3D>(parent, id, t_coord3D, value, min, max, readOnly, varFun);
   }
 
   //init a range slider, range between 0 and 255!
   JsonObject initSlider(JsonObject parent, const char * id, int value = UINT16_MAX, int min = 0, int max = 255, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "range", value, min, max, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_range, value, min, max, readOnly, varFun);
   }
   //init a range slider using referenced value
   JsonObject initSlider(JsonObject parent, const char * id, unsigned8 * value = nullptr, int min = 0, int max = 255, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<unsigned8>(parent, id, "range", value, min, max, readOnly, varFun);
+    return initVarAndUpdate<unsigned8>(parent, id, t_range, value, min, max, readOnly, varFun);
   }
 
   JsonObject initCanvas(JsonObject parent, const char * id, int value = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "canvas", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_canvas, value, 0, 0, readOnly, varFun);
   }
 
   //supports 3 state value: if UINT16_MAX it is indeterminated
   JsonObject initCheckBox(JsonObject parent, const char * id, int value = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "checkbox", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_checkbox, value, 0, 0, readOnly, varFun);
   }
   //init a checkbox using referenced value
   JsonObject initCheckBox(JsonObject parent, const char * id, bool * value = nullptr, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<bool>(parent, id, "checkbox", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<bool>(parent, id, t_checkbox, value, 0, 0, readOnly, varFun);
   }
 
   //a button never gets a value
   JsonObject initButton(JsonObject parent, const char * id, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<bool>(parent, id, "button", false, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<bool>(parent, id, t_button, false, 0, 0, readOnly, varFun);
   }
 
   //int value ?
   JsonObject initSelect(JsonObject parent, const char * id, int value = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "select", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_select, value, 0, 0, readOnly, varFun);
   }
   //init a select using referenced value
   JsonObject initSelect(JsonObject parent, const char * id, unsigned8 * value = nullptr, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<unsigned8>(parent, id, "select", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<unsigned8>(parent, id, t_select, value, 0, 0, readOnly, varFun);
   }
 
   JsonObject initIP(JsonObject parent, const char * id, int value = UINT16_MAX, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<int>(parent, id, "ip", value, 0, 255, readOnly, varFun);
+    return initVarAndUpdate<int>(parent, id, t_ip, value, 0, 255, readOnly, varFun);
   }
 
   JsonObject initTextArea(JsonObject parent, const char * id, const char * value = nullptr, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<const char *>(parent, id, "textarea", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<const char *>(parent, id, t_textarea, value, 0, 0, readOnly, varFun);
   }
 
   JsonObject initURL(JsonObject parent, const char * id, const char * value = nullptr, bool readOnly = false, VarFun varFun = nullptr) {
-    return initVarAndUpdate<const char *>(parent, id, "url", value, 0, 0, readOnly, varFun);
+    return initVarAndUpdate<const char *>(parent, id, t_url, value, 0, 0, readOnly, varFun);
   }
 
   //initVarAndUpdate using referenced value
   template <typename Type>
-  JsonObject initVarAndUpdate(JsonObject parent, const char * id, const char * type, Type * value, int min = 0, int max = 255, bool readOnly = true, VarFun varFun = nullptr) {
+  JsonObject initVarAndUpdate(JsonObject parent, const char * id, unsigned8 type, Type * value, int min = 0, int max = 255, bool readOnly = true, VarFun varFun = nullptr) {
     JsonObject var = initVarAndUpdate(parent, id, type, *value, min, max, readOnly, varFun, (int)value); //call with extra parameter: int of the pointer
     return var;
   }
 
   template <typename Type>
-  JsonObject initVarAndUpdate(JsonObject parent, const char * id, const char * type, Type value, int min = 0, int max = 255, bool readOnly = true, VarFun varFun = nullptr, int pointer = 0) {
+  JsonObject initVarAndUpdate(JsonObject parent, const char * id, unsigned8 type, Type value, int min = 0, int max = 255, bool readOnly = true, VarFun varFun = nullptr, int pointer = 0) {
     JsonObject var = initVar(parent, id, type, readOnly, varFun);
+    if (var.isNull()) return var; //unknown type
     if (pointer != 0) {
       if (mdl->setValueRowNr == UINT8_MAX)
         var["p"] = pointer; //store pointer!
@@ -173,7 +174,7 @@ public:
     if (max && max != UINT16_MAX) var["max"] = max;
 
     bool valueNeedsUpdate = false;
-    if (strcmp(type, "button") != 0) { //button never gets a value
+    if (varTypeInfo[type].hasValue) { //button never gets a value
       if (var["value"].isNull()) {
         valueNeedsUpdate = true;
         // print->printJson("initVarAndUpdate varFun value is null", var);
@@ -199,7 +200,7 @@ public:
     }
     else { //do onChange on existing value
       //no call of onChange for buttons otherwise all buttons will be fired which is highly undesirable
-      if (strcmp(type,"button") != 0 && varFun ) { //!isPointer because 0 is also a value then && (!isPointer || value)
+      if (varTypeInfo[type].hasValue && varFun ) { //!isPointer because 0 is also a value then && (!isPointer || value)
         bool onChangeExists = false;
         if (var["value"].is<JsonArray>()) {
           int rowNr = 0;
@@ -219,7 +220,7 @@ public:
     return var;
   }
 
-  JsonObject initVar(JsonObject parent, const char * id, const char * type, bool readOnly = true, VarFun varFun = nullptr);
+  JsonObject initVar(JsonObject parent, const char * id, unsigned8 type, bool readOnly = true, VarFun varFun = nullptr);
 
   //checks if var has fun of type funType implemented by calling it and checking result (for onUI on RO var, also onSetValue is called)
   bool callVarFun(const char * varID, unsigned8 rowNr = UINT8_MAX, unsigned8 funType = onSetValue) {
@@ -280,7 +281,7 @@ public:
   }
 
   //interpret json and run commands or set values like deserializeJson / deserializeState / deserializeConfig
-  void processJson(JsonVariant json); //must be Variant, not object for jsonhandler
+  bool processJson(JsonVariant json); //must be Variant, not object for jsonhandler. false if a var or command was not found
 
   //called to rebuild selects and tables (tbd: also label and comments is done again, that is not needed)
   // void processOnUI(const char * id);
@@ -23,18 +23,433 @@
 #include "AsyncJson.h"
 
 #include <ArduinoOTA.h>
+#include <atomic>
+#include <string>
 
 //https://techtutorialsx.com/2018/08/24/esp32-web-server-serving-html-from-file-system/
 //https://randomnerdtutorials.com/esp32-async-web-server-espasyncwebserver-library/
 
+//not in SysModWeb.h as SysModModel.h (VarHandle) includes SysModWeb.h
+static VarHandle<> wsSendVar;
+static VarHandle<> wsRecvVar;
+static VarHandle<> udpSendVar;
+static VarHandle<> udpRecvVar;
+static VarHandle<> wsPoolVar;
+
+//responseDoc of each task (loopTask, async_tcp, ...), task local: no task name lookup per addResponse
+static thread_local JsonDocument * taskResponseDoc = nullptr;
+
+//clTbl values per client, to refresh only changed rows
+struct ClientRow {
+  uint32_t id;
+  uint32_t ip;
+  unsigned8 status;
+  unsigned8 queueLength;
+  bool isFull;
+};
+static std::vector<ClientRow> clientRows;
+static TableRefresh clTblRefresh;
+static VarColumn<unsigned32> clNrColumn;
+static VarColumn<String> clIpColumn;
+static VarColumn<bool> clIsFullColumn;
+static VarColumn<unsigned8> clStatusColumn;
+static VarColumn<unsigned8> clLengthColumn;
+
+//binary values: scalar values and cells are send as a binary frame to clients which asked for it ({"binary":true})
+//  frame: WS_BINARY_VALUES, then per value: var nr (uint16), rowNr (uint8, UINT8_MAX: no row), tag (uint8), value
+//  var nrs are send to the client as {"binaryVars":[id, ...]} (index is nr), little endian as the ESP32
+#define WS_BINARY_VALUES 250 //first byte of binary frame, WS_FIRST_CHANNEL.. are channel nrs (see addChannel)
+#define WS_FIRST_CHANNEL 100 //first bytes below are frame ids of the app (userFun in app.js)
+enum BinaryTags { b_bool = 1, b_int32, b_uint32, b_double, b_string };
+
+//json text over 8192 bytes which can not be split: binary frames of WS_BINARY_FRAGMENT, flags (1: first, 2: last), part of the text
+#define WS_BINARY_FRAGMENT 251
+#define WS_FRAGMENT_SIZE 8190 //frame of 8192 bytes
+static std::unordered_map<std::string, unsigned16> binaryVarNrs; //var id -> nr (not the id hash: ids with the same hash each have their own nr)
+static std::vector<std::pair<uint32_t, unsigned16>> binaryClients; //client id, nr of vars it knows. Changed under modelMutex
+
+static unsigned16 binaryVarNr(const char * id) {
+  auto it = binaryVarNrs.find(id);
+  if (it != binaryVarNrs.end()) return it->second;
+  unsigned16 nr = binaryVarNrs.size();
+  binaryVarNrs[id] = nr;
+  return nr;
+}
+
+//give all vars a nr and add their ids by nr to binaryVars
+static void binaryVarsToJson(JsonArray vars, JsonArray binaryVars) {
+  for (JsonObject var: vars) {
+    binaryVars[binaryVarNr(var["id"])] = var["id"]; //linked id, binaryVars send before the model changes
+    if (var["n"].is<JsonArray>()) binaryVarsToJson(var["n"], binaryVars);
+  }
+}
+
+static bool isBinaryClient(WebClient * client) {
+  for (auto &binaryClient: binaryClients)
+    if (binaryClient.first == client->id()) return true;
+  return false;
+}
+
+//add value to frame if it is a scalar (and fits in a ws message)
+static bool encodeBinaryValue(std::vector<byte> &frame, unsigned16 nr, unsigned8 rowNr, JsonVariant value) {
+  byte tag;
+  union {bool b; int32_t i; uint32_t u; double d;} raw;
+  size_t size;
+  const char * string = nullptr;
+  if (value.is<bool>()) {tag = b_bool; raw.b = value; size = 1;}
+  else if (value.is<int32_t>()) {tag = b_int32; raw.i = value; size = 4;}
+  else if (value.is<uint32_t>()) {tag = b_uint32; raw.u = value; size = 4;}
+  else if (value.is<double>()) {tag = b_double; raw.d = value; size = 8;}
+  else if (value.is<const char *>()) {tag = b_string; string = value; size = 2 + strlen(string);}
+  else return false; //objects, arrays: json
+
+  if (frame.size() + 4 + size > 8192) return false;
+
+  frame.push_back(nr & 0xFF);
+  frame.push_back(nr >> 8);
+  frame.push_back(rowNr);
+  frame.push_back(tag);
+  if (string) {
+    unsigned16 len = size - 2;
+    frame.push_back(len & 0xFF);
+    frame.push_back(len >> 8);
+    frame.insert(frame.end(), string, string + len);
+  }
+  else
+    frame.insert(frame.end(), (byte *)&raw, (byte *)&raw + size);
+  return true;
+}
+
+//encode the values and cells of vars with nr < knownVars in frame, the rest of responseObject in restDoc
+static void encodeBinaryValues(JsonObject responseObject, unsigned16 knownVars, std::vector<byte> &frame, JsonDocument &restDoc) {
+  frame.push_back(WS_BINARY_VALUES);
+  for (JsonPair pair: responseObject) {
+    auto it = pair.value().is<JsonObject>()?binaryVarNrs.find(pair.key().c_str()):binaryVarNrs.end();
+    if (it == binaryVarNrs.end() || it->second >= knownVars) {
+      restDoc[pair.key()] = pair.value();
+      continue;
+    }
+    for (JsonPair property: pair.value().as<JsonObject>()) {
+      if (property.key() == "value" && encodeBinaryValue(frame, it->second, UINT8_MAX, property.value()))
+        continue;
+      if (property.key() == "cells" && property.value().is<JsonObject>()) {
+        for (JsonPair cell: property.value().as<JsonObject>())
+          if (!encodeBinaryValue(frame, it->second, atoi(cell.key().c_str()), cell.value()))
+            restDoc[pair.key()]["cells"][cell.key()] = cell.value();
+        continue;
+      }
+      restDoc[pair.key()][property.key()] = property.value();
+    }
+  }
+}
+
+//outbox per client which can not keep up (queue full): pending var updates, latest value wins per var property and cell
+//  so memory is bounded by the model and a lagging client converges to the current state. Changed under wsMutex
+static std::unordered_map<uint32_t, JsonDocument> outboxes; //client id -> {id:{property:value, cells:{rowNr:value}}}
+
+static void mergeIntoOutbox(JsonObject outbox, JsonObject responseObject) {
+  for (JsonPair pair: responseObject) {
+    JsonString id = JsonString(pair.key().c_str(), JsonString::Copied); //responseDoc is recreated after sending
+    if (!pair.value().is<JsonObject>()) {
+      outbox[id] = pair.value();
+      continue;
+    }
+    JsonObject outVar = outbox[id].is<JsonObject>()?outbox[id].as<JsonObject>():outbox[id].to<JsonObject>();
+    for (JsonPair property: pair.value().as<JsonObject>()) {
+      if (property.key() == "cells" && property.value().is<JsonObject>()) {
+        JsonObject outCells = outVar["cells"].is<JsonObject>()?outVar["cells"].as<JsonObject>():outVar["cells"].to<JsonObject>();
+        for (JsonPair cell: property.value().as<JsonObject>())
+          outCells[JsonString(cell.key().c_str(), JsonString::Copied)] = cell.value();
+      }
+      else {
+        if (property.key() == "value") outVar.remove("cells"); //whole value supersedes older cells
+        outVar[JsonString(property.key().c_str(), JsonString::Copied)] = property.value();
+      }
+    }
+  }
+}
+
+//binary streams, see addChannel
+struct ChannelClient {
+  uint32_t id;
+  unsigned16 interval; //ms between frames, from the fps the client asked for
+  unsigned long lastMillis;
+};
+struct Channel {
+  const char * name;
+  unsigned8 fps;
+  bool lossy;
+  std::vector<ChannelClient> clients; //subscribed clients, changed under wsMutex
+};
+static std::vector<Channel> channels; //added in setup, index is channel nr
+
+//modules serialized for ws connects, in varOrder. The ws buffers stay locked by the cache and are shared by all
+//  connecting clients (each queued send is counted by the buffer). Invalidated per module on the next connect if a value
+//  changed (see modelValueChanged), all on structure changes (see invalidateModelCache). Changed under wsMutex
+struct ModuleBlob {
+  size_t index; //of the module in the model
+  uint32_t idHash; //of the module id
+  AsyncWebSocketMessageBuffer * wsBuf; //nullptr: serialize on next connect
+};
+static std::vector<ModuleBlob> moduleBlobs; //empty: sort the modules again on next connect
+static std::unordered_map<uint32_t, unsigned8> moduleBlobOfVar; //varIdHash -> moduleBlobs index
+
+static void mapVarsToBlob(JsonArray vars, unsigned8 blobNr) {
+  for (JsonObject var: vars) {
+    moduleBlobOfVar[SysModModel::varIdHash(var["id"])] = blobNr;
+    if (var["n"].is<JsonArray>()) mapVarsToBlob(var["n"], blobNr);
+  }
+}
+
+//modules in varOrder and the module of each var (under modelMutex and wsMutex)
+static void buildModuleBlobs(JsonArray model) {
+  //inspired by https://github.com/bblanchon/ArduinoJson/issues/1280
+  //store arrayindex and sort order in vector
+  std::vector<ArrayIndexSortValue> aisvs;
+  size_t index = 0;
+  for (JsonObject moduleVar: model) {
+    ArrayIndexSortValue aisv;
+    aisv.index = index++;
+    aisv.value = mdl->varOrder(moduleVar);
+    aisvs.push_back(aisv);
+  }
+  //sort the vector by the order
+  std::sort(aisvs.begin(), aisvs.end(), [](const ArrayIndexSortValue &a, const ArrayIndexSortValue &b) {return a.value < b.value;});
+
+  for (const ArrayIndexSortValue &aisv : aisvs) {
+    uint32_t idHash = SysModModel::varIdHash(model[aisv.index]["id"]);
+    moduleBlobOfVar[idHash] = moduleBlobs.size();
+    mapVarsToBlob(model[aisv.index]["n"], moduleBlobs.size());
+    moduleBlobs.push_back({aisv.index, idHash, nullptr});
+  }
+}
+
+//modules shown by a client ({"visible":[module ids]}): broadcasts to that client only contain vars of these modules
+static std::unordered_map<uint32_t, std::vector<uint32_t>> clientViews; //client id -> module idHashes. Changed under wsMutex
+
+static bool inView(const std::vector<uint32_t> &view, const char * id) {
+  auto it = moduleBlobOfVar.find(SysModModel::varIdHash(id));
+  if (it == moduleBlobOfVar.end()) return true; //not a var of a module (or modules not mapped yet)
+  return std::find(view.begin(), view.end(), moduleBlobs[it->second].idHash) != view.end();
+}
+
+//values of vars (recursive), for a client which shows a module again
+static void valuesToJson(JsonArray vars, JsonObject values) {
+  for (JsonObject var: vars) {
+    if (!var["value"].isNull()) values[var["id"].as<const char *>()]["value"] = var["value"]; //linked id, send under modelMutex
+    if (var["n"].is<JsonArray>()) valuesToJson(var["n"], values);
+  }
+}
+
+//ws message pool: ws buffers kept locked and reused once all clients sent them, instead of a heap allocation per message
+//  the ws lib sends the full length of a buffer (no separate wire length), so a buffer is only reused for messages of exactly its length
+//  a length is taken into the pool when it is asked for twice in a row (e.g. a fixed size stream or a recurring value message),
+//  other lengths get a buffer for one message, so changing lengths do not churn the pooled buffers
+//  allocated by the ws lib (so in PSRAM if malloc puts large blocks there). Changed under wsMutex
+struct PoolBuffer {
+  AsyncWebSocketMessageBuffer * wsBuf;
+  bool inUse; //being filled and queued by sendDataWs
+  unsigned32 lastUsed; //wsPoolUses when last taken, the least recently used free buffer is replaced
+};
+#define WS_POOL_MAX_BUFFERS 16
+#ifndef WS_POOL_BYTES //all pooled buffers
+  #ifdef BOARD_HAS_PSRAM
+    #define WS_POOL_BYTES 65536
+  #else
+    #define WS_POOL_BYTES 16384
+  #endif
+#endif
+static std::vector<PoolBuffer> wsPool;
+static size_t wsPoolBytes = 0;
+static unsigned32 wsPoolUses = 0;
+static size_t wsPoolMissLen = 0; //length of the last miss, pooled if asked for again
+static unsigned16 wsPoolHits = 0;
+static unsigned16 wsPoolMisses = 0; //no pooled buffer of this length (or message too large): allocated for one message
+
+//free buffer of the pool for a message of len, nullptr if none
+static PoolBuffer * wsPoolGet(WebSocket &ws, size_t len) {
+  if (len > 8192) return nullptr;
+  if (wsPool.empty()) wsPool.reserve(WS_POOL_MAX_BUFFERS); //no reallocation: PoolBuffer pointers stay valid
+  wsPoolUses++;
+
+  PoolBuffer * leastUsed = nullptr; //free buffer of another length
+  for (PoolBuffer &poolBuffer: wsPool) {
+    if (!poolBuffer.inUse && poolBuffer.wsBuf->count() == 0) { //all clients sent it
+      if (poolBuffer.wsBuf->length() == len) {
+        poolBuffer.inUse = true;
+        poolBuffer.lastUsed = wsPoolUses;
+        wsPoolHits++;
+        return &poolBuffer;
+      }
+      if (!leastUsed || poolBuffer.lastUsed < leastUsed->lastUsed) leastUsed = &poolBuffer;
+    }
+  }
+
+  if (len != wsPoolMissLen) { //first time (in a row) of this length: not pooled
+    wsPoolMissLen = len;
+    return nullptr;
+  }
+
+  bool add = wsPool.size() < WS_POOL_MAX_BUFFERS && wsPoolBytes + len <= WS_POOL_BYTES;
+  if (!add && !(leastUsed && wsPoolBytes - leastUsed->wsBuf->length() + len <= WS_POOL_BYTES))
+    return nullptr; //no room
+
+  AsyncWebSocketMessageBuffer * wsBuf = ws.makeBuffer(len);
+  if (!wsBuf) return nullptr;
+  PoolBuffer * poolBuffer;
+  if (add) {
+    wsPool.push_back({wsBuf, true, wsPoolUses});
+    poolBuffer = &wsPool.back();
+  }
+  else { //replace the least recently used free buffer
+    poolBuffer = leastUsed;
+    wsPoolBytes -= poolBuffer->wsBuf->length();
+    poolBuffer->wsBuf->unlock(); //freed by _cleanBuffers
+    poolBuffer->wsBuf = wsBuf;
+  }
+  poolBuffer->wsBuf->lock(); //owned by the pool
+  poolBuffer->inUse = true;
+  poolBuffer->lastUsed = wsPoolUses;
+  wsPoolBytes += len;
+  wsPoolMisses++; //allocated for this message
+  return poolBuffer;
+}
+
+//text messages in multiple frames are reassembled per client (in the async_tcp task), up to WS_MAX_MESSAGE bytes
+#ifndef WS_MAX_MESSAGE
+  #define WS_MAX_MESSAGE 16384
+#endif
+struct WsFragments {
+  std::vector<byte> message;
+  bool tooLarge = false; //rest of the message is skipped and answered with an error
+};
+static std::unordered_map<uint32_t, WsFragments> wsFragments; //client id -> message so far
+
+//embedded UI changes only with a new build (SysModWeb.cpp includes html_ui.h)
+static const char * indexETag = "\"" TOSTRING(APP) "_" TOSTRING(VERSION) "_" __DATE__ " " __TIME__ "\"";
+
+//content type by file extension (/file/*)
+static const char * contentType(const char * path) {
+  const char * ext = strrchr(path, '.');
+  if (!ext) return "text/plain";
+  if (strcmp(ext, ".htm") == 0 || strcmp(ext, ".html") == 0) return "text/html";
+  if (strcmp(ext, ".css") == 0) return "text/css";
+  if (strcmp(ext, ".js") == 0) return "application/javascript";
+  if (strcmp(ext, ".json") == 0) return "application/json";
+  if (strcmp(ext, ".png") == 0) return "image/png";
+  if (strcmp(ext, ".jpg") == 0 || strcmp(ext, ".jpeg") == 0) return "image/jpeg";
+  if (strcmp(ext, ".gif") == 0) return "image/gif";
+  if (strcmp(ext, ".svg") == 0) return "image/svg+xml";
+  if (strcmp(ext, ".ico") == 0) return "image/x-icon";
+  if (strcmp(ext, ".gz") == 0) return "application/gzip";
+  if (strcmp(ext, ".bin") == 0) return "application/octet-stream";
+  return "text/plain";
+}
+
+//Print into a slice of a fixed buffer: skips the first skip bytes, keeps at most room bytes, counts all (total)
+struct SliceWriter: Print {
+  char * dest;
+  size_t room;
+  size_t skip;
+  size_t written = 0;
+  size_t total = 0;
+  SliceWriter(char * dest, size_t room, size_t skip) : dest(dest), room(room), skip(skip) {}
+  size_t write(uint8_t c) override {
+    if (total++ >= skip && written < room) dest[written++] = c;
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    for (size_t i = 0; i < size; i++) write(buffer[i]);
+    return size;
+  }
+};
+
+//progress of a /json/mdl response: the loop task serializes the model into snapshot, one var at a time, the chunk callback sends it
+//  a var is written with its own properties ("head") and then its children, so no module is serialized at once: the peak is the
+//  snapshot buffer whatever the size of a module. The position is the path of var indexes: if the model changes between
+//  passes the JSON stays valid (vars may be skipped or sent twice). Only a head larger than the buffer is split over passes
+#define MODEL_STREAM_BYTES 4096
+struct ModelStream {
+  enum State: unsigned8 {idle, requested, ready, last, done};
+  std::atomic<unsigned8> state{idle}; //idle -> requested (runInLoop) -> ready (snapshot set) -> idle (sent) ... last -> done
+  std::vector<unsigned16> path; //index of the next var per depth, empty: not started
+  size_t headOffset = 0; //bytes of the head of the var at path already in previous snapshots
+  char snapshot[MODEL_STREAM_BYTES];
+  size_t length = 0; //bytes in snapshot
+  size_t offset = 0; //bytes of snapshot already sent
+
+  //vars of the array at depth of path (model if depth 0), null if gone
+  JsonArray varsAt(JsonArray model, size_t depth) {
+    JsonArray vars = model;
+    for (size_t i = 0; i < depth && !vars.isNull(); i++) vars = vars[path[i]]["n"];
+    return vars;
+  }
+
+  //own properties of var, separator and the start of its children: ,{"id":..,"n":[
+  void writeHead(Print &writer, JsonObject var, bool separator, bool hasChildren) {
+    writer.print(separator?",{":"{");
+    bool first = true;
+    for (JsonPair pair: var) {
+      if (pair.key() == "n") continue;
+      writer.print(first?"\"":",\""); //keys are var property names: no escaping needed
+      writer.print(pair.key().c_str());
+      writer.print("\":");
+      serializeJson(pair.value(), writer);
+      first = false;
+    }
+    if (hasChildren) writer.print(first?"\"n\":[":",\"n\":[");
+    else writer.print("}");
+  }
+
+  //next part of the model into snapshot, in the loop task (under modelMutex)
+  void fill(JsonArray model) {
+    length = 0;
+    if (path.empty()) {
+      snapshot[length++] = '[';
+      path.push_back(0);
+    }
+    while (length < MODEL_STREAM_BYTES - 4) { //room for the closing brackets
+      JsonArray vars = varsAt(model, path.size() - 1);
+      unsigned16 index = path.back();
+      if (vars.isNull() || index >= vars.size()) { //end of the vars at this depth
+        path.pop_back();
+        headOffset = 0;
+        if (path.empty()) {
+          snapshot[length++] = ']';
+          state = last;
+          return;
+        }
+        snapshot[length++] = ']';
+        snapshot[length++] = '}';
+        path.back()++;
+        continue;
+      }
+      JsonObject var = vars[index];
+      bool hasChildren = var["n"].is<JsonArray>();
+      SliceWriter writer(snapshot + length, MODEL_STREAM_BYTES - length, headOffset);
+      writeHead(writer, var, index > 0, hasChildren);
+      if (headOffset + writer.written < writer.total) { //head does not fit
+        if (length > 1 && !headOffset) break; //more than the opening [ written: next snapshot, from the start of the head
+        length += writer.written; //larger than the buffer: split
+        headOffset += writer.written;
+        break;
+      }
+      length += writer.written;
+      headOffset = 0;
+      if (hasChildren) path.push_back(0);
+      else path.back()++;
+    }
+    state = ready;
+  }
+};
+
 SysModWeb::SysModWeb() :SysModule("Web") {
   //CORS compatiblity
   DefaultHeaders::Instance().addHeader(F("Access-Control-Allow-Origin"), "*");
   DefaultHeaders::Instance().addHeader(F("Access-Control-Allow-Methods"), "*");
   DefaultHeaders::Instance().addHeader(F("Access-Control-Allow-Headers"), "*");
 
-  responseDocLoopTask = new JsonDocument; responseDocLoopTask->to<JsonObject>();
-  responseDocAsyncTCP = new JsonDocument; responseDocAsyncTCP->to<JsonObject>();
+  registerResponseDoc(); //loopTask, other tasks (async_tcp) on first use
 };
 
 void SysModWeb::setup() {
@@ -47,11 +462,15 @@ void SysModWeb::setup() {
       return true;
     default: return false;
   }});
+  clTblRefresh.attach(tableVar);
 
   ui->initNumber(tableVar, "clNr", UINT16_MAX, 0, 999, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue: {
-      unsigned8 rowNr = 0; for (auto client:ws.getClients())
-        mdl->setValue(var, client->id(), rowNr++);
+      clNrColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < clientRows.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        clNrColumn.set(rowNrL, clientRows[rowNrL].id);
+      if (rowNr == UINT8_MAX) clNrColumn.resize(clientRows.size()); //remove rows of disconnected clients
+      clNrColumn.commit();
       return true; }
     case onUI:
       ui->setLabel(var, "Nr");
@@ -61,8 +480,11 @@ void SysModWeb::setup() {
 
   ui->initText(tableVar, "clIp", nullptr, 16, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue: {
-      unsigned8 rowNr = 0; for (auto client:ws.getClients())
-        mdl->setValue(var, JsonString(client->remoteIP().toString().c_str(), JsonString::Copied), rowNr++);
+      clIpColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < clientRows.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        clIpColumn.set(rowNrL, IPAddress(clientRows[rowNrL].ip).toString());
+      if (rowNr == UINT8_MAX) clIpColumn.resize(clientRows.size()); //remove rows of disconnected clients
+      clIpColumn.commit();
       return true; }
     case onUI:
       ui->setLabel(var, "IP");
@@ -72,8 +494,11 @@ void SysModWeb::setup() {
 
   ui->initCheckBox(tableVar, "clIsFull", UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue: {
-      unsigned8 rowNr = 0; for (auto client:ws.getClients())
-        mdl->setValue(var, client->queueIsFull(), rowNr++);
+      clIsFullColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < clientRows.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        clIsFullColumn.set(rowNrL, clientRows[rowNrL].isFull);
+      if (rowNr == UINT8_MAX) clIsFullColumn.resize(clientRows.size()); //remove rows of disconnected clients
+      clIsFullColumn.commit();
       return true; }
     case onUI:
       ui->setLabel(var, "Is full");
@@ -83,8 +508,11 @@ void SysModWeb::setup() {
 
   ui->initSelect(tableVar, "clStatus", UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue: {
-      unsigned8 rowNr = 0; for (auto client:ws.getClients())
-        mdl->setValue(var, client->status(), rowNr++);
+      clStatusColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < clientRows.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        clStatusColumn.set(rowNrL, clientRows[rowNrL].status);
+      if (rowNr == UINT8_MAX) clStatusColumn.resize(clientRows.size()); //remove rows of disconnected clients
+      clStatusColumn.commit();
       return true; }
     case onUI:
     {
@@ -101,8 +529,11 @@ void SysModWeb::setup() {
 
   ui->initNumber(tableVar, "clLength", UINT16_MAX, 0, WS_MAX_QUEUED_MESSAGES, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue: {
-      unsigned8 rowNr = 0; for (auto client:ws.getClients())
-        mdl->setValue(var, client->queueLength(), rowNr++);
+      clLengthColumn.attach(var);
+      for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < clientRows.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++)
+        clLengthColumn.set(rowNrL, clientRows[rowNrL].queueLength);
+      if (rowNr == UINT8_MAX) clLengthColumn.resize(clientRows.size()); //remove rows of disconnected clients
+      clLengthColumn.commit();
       return true; }
     case onUI:
       ui->setLabel(var, "Length");
@@ -112,7 +543,7 @@ void SysModWeb::setup() {
 
   ui->initNumber(parentVar, "maxQueue", WS_MAX_QUEUED_MESSAGES, 0, WS_MAX_QUEUED_MESSAGES, true);
 
-  ui->initText(parentVar, "wsSend", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  wsSendVar = ui->initText(parentVar, "wsSend", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "WS Send");
       // ui->setComment(var, "web socket calls");
@@ -120,7 +551,7 @@ void SysModWeb::setup() {
     default: return false;
   }});
 
-  ui->initText(parentVar, "wsRecv", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  wsRecvVar = ui->initText(parentVar, "wsRecv", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "WS Recv");
       // ui->setComment(var, "web socket calls");
@@ -128,20 +559,71 @@ void SysModWeb::setup() {
     default: return false;
   }});
 
-  ui->initText(parentVar, "udpSend", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  wsPoolVar = ui->initText(parentVar, "wsPool", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setLabel(var, "WS Pool");
+      ui->setComment(var, "Reused message buffers, misses: allocated per message");
+      return true;
+    default: return false;
+  }});
+
+  udpSendVar = ui->initText(parentVar, "udpSend", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "UDP Send");
       return true;
     default: return false;
   }});
 
-  ui->initText(parentVar, "udpRecv", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+  udpRecvVar = ui->initText(parentVar, "udpRecv", nullptr, 16, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onUI:
       ui->setLabel(var, "UDP Recv");
       return true;
     default: return false;
   }});
 
+  #ifdef STARBASE_DEVMODE
+  ui->initButton(parentVar, "binaryBenchmark", false, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setComment(var, "Encode 50 updates/s of 20 vars: json vs binary");
+      return true;
+    case onChange: {
+      //20 vars with a number value
+      std::vector<const char *> ids;
+      for (bool ro: {false, true})
+        mdl->findVars("ro", ro, [&ids](JsonObject var) { //findFun
+          if (ids.size() < 20 && var["value"].is<int>()) ids.push_back(var["id"]);
+        });
+      for (const char * id: ids) binaryVarNr(id);
+
+      size_t jsonBytes = 0, binaryBytes = 0;
+      unsigned long jsonTime = 0, binaryTime = 0;
+      for (int update = 0; update < 50; update++) {
+        JsonDocument updates;
+        for (int i = 0; i < ids.size(); i++)
+          updates[ids[i]]["value"] = update * 20 + i;
+
+        unsigned long start = micros();
+        size_t len = measureJson(updates);
+        char buffer[len + 1];
+        serializeJson(updates, buffer, len + 1);
+        jsonTime += micros() - start;
+        jsonBytes += len;
+
+        start = micros();
+        std::vector<byte> frame;
+        JsonDocument restDoc;
+        encodeBinaryValues(updates.as<JsonObject>(), UINT16_MAX, frame, restDoc);
+        binaryTime += micros() - start;
+        binaryBytes += frame.size();
+      }
+
+      ppf("dev binaryBenchmark %d vars x 50/s: json %d B/s %lu µs/s, binary %d B/s %lu µs/s\n", ids.size(), jsonBytes, jsonTime, binaryBytes, binaryTime);
+      web->addResponseV(var["id"], "comment", "%d vars x 50/s: json %d B/s %lu µs/s, binary %d B/s %lu µs/s", ids.size(), jsonBytes, jsonTime, binaryBytes, binaryTime);
+      return true; }
+    default: return false;
+  }});
+  #endif
+
 }
 
 void SysModWeb::loop20ms() {
@@ -158,28 +640,160 @@ void SysModWeb::loop20ms() {
     clientsChanged = false;
 
     // ppf("SysModWeb clientsChanged\n");
-    for (JsonObject childVar: mdl->varChildren("clTbl"))
-      ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP)
+    updateClientRows(); //current clients, not those of the last loop1s
+    clTblRefresh.rowChanged(); //clients added or removed: all rows
   }
 
+  clTblRefresh.refresh(clientRows.size());
+
+  flushOutboxes();
+}
+
+void SysModWeb::sendDataWsSplit(JsonObject json, WebClient * client, std::function<bool(WebClient *)> filter, JsonObject unsent) {
+  JsonDocument message;
+  bool full = false;
+  auto sendMessage = [&]() {
+    if (!unsent.isNull() && client && !full) {
+      xSemaphoreTake(wsMutex, portMAX_DELAY);
+      full = client->queueIsFull(); //sendDataWs would skip it
+      xSemaphoreGive(wsMutex);
+    }
+    if (full) {
+      for (JsonPair pair: message.as<JsonObject>())
+        unsent[pair.key()] = pair.value();
+    }
+    else
+      sendDataWs(message.as<JsonObject>(), client, filter);
+    message.clear();
+  };
+  for (JsonPair pair: json) {
+    if (message.size() && measureJson(message) + measureJson(pair.value()) + strlen(pair.key().c_str()) + 4 > 8192)
+      sendMessage();
+    message[pair.key()] = pair.value();
+  }
+  if (message.size())
+    sendMessage();
+}
+
+void SysModWeb::viewCommand(WebClient * client, JsonObject command) {
+  JsonDocument valuesDoc;
+  JsonObject values = valuesDoc.to<JsonObject>();
+
+  xSemaphoreTake(mdl->modelMutex, portMAX_DELAY);
+  JsonArray model = mdl->model->as<JsonArray>();
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  if (moduleBlobs.empty()) buildModuleBlobs(model);
+
+  //no view: all modules
+  std::vector<uint32_t> view;
+  if (command["visible"].is<JsonArray>())
+    for (JsonVariant moduleId: command["visible"].as<JsonArray>())
+      view.push_back(SysModModel::varIdHash(moduleId));
+  else
+    for (ModuleBlob &blob: moduleBlobs) view.push_back(blob.idHash);
+
+  //modules shown again get their current values (no view before: client has all)
+  auto oldView = clientViews.find(client->id());
+  if (oldView != clientViews.end()) {
+    for (ModuleBlob &blob: moduleBlobs)
+      if (std::find(view.begin(), view.end(), blob.idHash) != view.end() && std::find(oldView->second.begin(), oldView->second.end(), blob.idHash) == oldView->second.end())
+        valuesToJson(model[blob.index]["n"], values);
+  }
+
+  if (command["visible"].is<JsonArray>())
+    clientViews[client->id()] = view;
+  else
+    clientViews.erase(client->id());
+  xSemaphoreGive(wsMutex);
+
+  command.remove("visible");
+  if (values.size())
+    sendDataWsSplit(values, client);
+  xSemaphoreGive(mdl->modelMutex);
+}
+
+void SysModWeb::flushOutboxes() {
+  //take the outboxes of clients which drained their queue, the (empty) outbox stays until send so newer values queue after it
+  std::vector<std::pair<uint32_t, JsonDocument>> ready;
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  for (auto it = outboxes.begin(); it != outboxes.end(); ) {
+    WebClient * loopClient = ws.client(it->first);
+    if (!loopClient || loopClient->status() != WS_CONNECTED)
+      it = outboxes.erase(it);
+    else {
+      if (it->second.size() && loopClient->queueLength() <= WS_MAX_QUEUED_MESSAGES / 2)
+        ready.push_back({it->first, std::move(it->second)});
+      ++it;
+    }
+  }
+  xSemaphoreGive(wsMutex);
+
+  std::vector<JsonDocument> unsentDocs(ready.size()); //messages not send as the queue filled up again
+  for (forUnsigned8 i = 0; i < ready.size(); i++) {
+    WebClient * loopClient = ws.client(ready[i].first);
+    if (loopClient) sendDataWsSplit(ready[i].second.as<JsonObject>(), loopClient, nullptr, unsentDocs[i].to<JsonObject>());
+    // ppf("dev flushOutboxes client %d %d vars\n", ready[i].first, ready[i].second.size());
+  }
+
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  for (forUnsigned8 i = 0; i < ready.size(); i++) {
+    auto it = outboxes.find(ready[i].first);
+    if (it == outboxes.end()) continue; //client gone
+    if (unsentDocs[i].size()) { //back in the outbox, values added while sending are newer
+      JsonDocument outbox;
+      mergeIntoOutbox(outbox.to<JsonObject>(), unsentDocs[i].as<JsonObject>());
+      mergeIntoOutbox(outbox.as<JsonObject>(), it->second.as<JsonObject>());
+      it->second = std::move(outbox);
+    }
+    else if (!it->second.size()) outboxes.erase(it); //nothing added while sending: client is up to date
+  }
+  xSemaphoreGive(wsMutex);
+}
+
+//check which clients changed (added, removed, status, queue): mark their clTbl rows, refreshed in loop20ms
+void SysModWeb::updateClientRows() {
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  unsigned8 rowNr = 0; for (auto client:ws.getClients()) {
+    ClientRow clientRow = {client->id(), (uint32_t)client->remoteIP(), (unsigned8)client->status(), (unsigned8)client->queueLength(), client->queueIsFull()};
+    if (rowNr >= clientRows.size()) {
+      clientRows.push_back(clientRow);
+      clTblRefresh.rowChanged(rowNr);
+    }
+    else {
+      ClientRow &oldRow = clientRows[rowNr];
+      if (oldRow.id != clientRow.id || oldRow.ip != clientRow.ip || oldRow.status != clientRow.status || oldRow.queueLength != clientRow.queueLength || oldRow.isFull != clientRow.isFull) {
+        oldRow = clientRow;
+        clTblRefresh.rowChanged(rowNr);
+      }
+    }
+    rowNr++;
+  }
+  clientRows.resize(rowNr);
+  xSemaphoreGive(wsMutex);
 }
 
 void SysModWeb::loop1s() {
-  for (JsonObject childVar: mdl->varChildren("clTbl"))
-    ui->callVarFun(childVar, UINT8_MAX, onSetValue); //set the value (WIP)
+  updateClientRows(); //status and queue of clients
 
-  mdl->setUIValueV("wsSend", "#: %d /s T: %d B/s B:%d B/s", sendWsCounter, sendWsTBytes, sendWsBBytes);
+  wsSendVar.setUIValueV("#: %d /s T: %d B/s B:%d B/s", sendWsCounter, sendWsTBytes, sendWsBBytes);
   sendWsCounter = 0;
   sendWsTBytes = 0;
   sendWsBBytes = 0;
-  mdl->setUIValueV("wsRecv", "#: %d /s %d B/s", recvWsCounter, recvWsBytes);
+  wsRecvVar.setUIValueV("#: %d /s %d B/s", recvWsCounter, recvWsBytes);
   recvWsCounter = 0;
   recvWsBytes = 0;
 
-  mdl->setUIValueV("udpSend", "#: %d /s %d B/s", sendUDPCounter, sendUDPBytes);
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  size_t poolBuffers = wsPool.size(), poolBytes = wsPoolBytes;
+  xSemaphoreGive(wsMutex);
+  wsPoolVar.setUIValueV("hit: %d /s miss: %d /s (%d: %d B)", wsPoolHits, wsPoolMisses, poolBuffers, poolBytes);
+  wsPoolHits = 0;
+  wsPoolMisses = 0;
+
+  udpSendVar.setUIValueV("#: %d /s %d B/s", sendUDPCounter, sendUDPBytes);
   sendUDPCounter = 0;
   sendUDPBytes = 0;
-  mdl->setUIValueV("udpRecv", "#: %d /s %d B/s", recvUDPCounter, recvUDPBytes);
+  udpRecvVar.setUIValueV("#: %d /s %d B/s", recvUDPCounter, recvUDPBytes);
   recvUDPCounter = 0;
   recvUDPBytes = 0;
 
@@ -243,6 +857,7 @@ void SysModWeb::wsEvent(WebSocket * ws, WebClient * client, AwsEventType type, v
 
   if (type == WS_EVT_CONNECT) {
     printClient("WS client connected", client);
+    wsConnects++;
 
     //send system constants
     getResponseObject()["sysInfo"]["board"] = CONFIG_IDF_TARGET;
@@ -252,36 +867,58 @@ void SysModWeb::wsEvent(WebSocket * ws, WebClient * client, AwsEventType type, v
     for (int i=0; i<NUM_DIGITAL_PINS; i++) {
       pinTypes.add(pinsM->getPinType(i));
     }
+    JsonArray varTypes = getResponseObject()["sysInfo"]["varTypes"].to<JsonArray>(); //var["type"] is send as number
+    for (forUnsigned8 type = 0; type < t_count; type++) {
+      varTypes.add(varTypeInfo[type].name); //const char *: not copied
+    }
 
     sendResponseObject(client);
 
+    xSemaphoreTake(mdl->modelMutex, portMAX_DELAY); //serialize from the live model while the loop task is not changing it
     JsonArray model = mdl->model->as<JsonArray>();
 
-    //inspired by https://github.com/bblanchon/ArduinoJson/issues/1280
-    //store arrayindex and sort order in vector
-    std::vector<ArrayIndexSortValue> aisvs;
-    size_t index = 0;
-    for (JsonObject moduleVar: model) {
-      ArrayIndexSortValue aisv;
-      aisv.index = index++;
-      aisv.value = mdl->varOrder(moduleVar);
-      aisvs.push_back(aisv);
-    }
-    //sort the vector by the order
-    std::sort(aisvs.begin(), aisvs.end(), [](const ArrayIndexSortValue &a, const ArrayIndexSortValue &b) {return a.value < b.value;});
-
-    //send model per module to stay under websocket size limit of 8192
-    for (const ArrayIndexSortValue &aisv : aisvs) {
-      sendDataWs(model[aisv.index], client); //send definition to client
+    xSemaphoreTake(wsMutex, portMAX_DELAY);
+    invalidateChangedModules();
+    if (moduleBlobs.empty()) buildModuleBlobs(model); //first connect or structure changed
+
+    //send model per module to stay under websocket size limit of 8192, serialized once and shared with the next connects
+    for (ModuleBlob &blob: moduleBlobs) {
+      if (!blob.wsBuf) {
+        size_t len = measureJson(model[blob.index]);
+        blob.wsBuf = ws.makeBuffer(len);
+        if (!blob.wsBuf) break; //out of memory, client will miss modules
+        blob.wsBuf->lock(); //kept until invalidated
+        serializeJson(model[blob.index], blob.wsBuf->get(), len);
+      }
+      if (client->status() == WS_CONNECTED && !client->queueIsFull()) {
+        client->text(blob.wsBuf);
+        sendWsCounter++;
+        sendWsTBytes+=blob.wsBuf->length();
+      }
+      else
+        printClient("WS connect client full or not connected", client);
     }
+    xSemaphoreGive(wsMutex);
+    xSemaphoreGive(mdl->modelMutex);
 
     clientsChanged = true;
   } else if (type == WS_EVT_DISCONNECT) {
     printClient("WS Client disconnected", client);
+    xSemaphoreTake(mdl->modelMutex, portMAX_DELAY); //binaryClients is used by the loop task
+    for (auto it = binaryClients.begin(); it != binaryClients.end(); ++it)
+      if (it->first == client->id()) {binaryClients.erase(it); break;}
+    xSemaphoreGive(mdl->modelMutex);
+    xSemaphoreTake(wsMutex, portMAX_DELAY);
+    outboxes.erase(client->id());
+    clientViews.erase(client->id());
+    for (Channel &channel: channels)
+      for (auto it = channel.clients.begin(); it != channel.clients.end(); ++it)
+        if (it->id == client->id()) {channel.clients.erase(it); break;}
+    xSemaphoreGive(wsMutex);
+    wsFragments.erase(client->id());
     clientsChanged = true;
   } else if (type == WS_EVT_DATA) {
     AwsFrameInfo * info = (AwsFrameInfo*)arg;
-    String msg = "";
     // ppf("  info %d %d %d=%d? %d %d\n", info->final, info->index, info->len, len, info->opcode, data[0]);
     if (info->final && info->index == 0 && info->len == len) { //not multipart
       recvWsCounter++;
@@ -289,94 +926,40 @@ void SysModWeb::wsEvent(WebSocket * ws, WebClient * client, AwsEventType type, v
       printClient("WS event data", client);
       // the whole message is in a single frame and we got all of its data (max. 1450 bytes)
       if (info->opcode == WS_TEXT)
-      {
-        if (len > 0 && len < 10 && data[0] == 'p') {
-          // application layer ping/pong heartbeat.
-          // client-side socket layer ping packets are unresponded (investigate)
-          // printClient("WS client pong", client); //crash?
-          ppf("pong\n");
-          client->text("pong");
-        } else {
-          JsonDocument *responseDoc = getResponseDoc(); //we need the doc for deserializeJson
-          JsonObject responseObject = getResponseObject();
-
-          DeserializationError error = deserializeJson(*responseDoc, data, len); //data to responseDoc
-
-          if (error || responseObject.isNull()) {
-            ppf("wsEvent deserializeJson failed with code %s\n", error.c_str());
-            client->text("{\"success\":true}"); // we have to send something back otherwise WS connection closes
-          } else {
-            bool isOnUI = !responseObject["onUI"].isNull();
-            ui->processJson(responseObject); //adds to responseDoc / responseObject
-
-            if (responseObject.size()) {
-              sendResponseObject(isOnUI?client:nullptr); //onUI only send to requesting client async response
-            }
-            else {
-              ppf("WS_EVT_DATA no responseDoc\n");
-              client->text("{\"success\":true}"); // we have to send something back otherwise WS connection closes
-            }
-          }
-        }
-      }
+        wsText(client, data, len); //no copy
     } else {
-      //message is comprised of multiple frames or the frame is split into multiple packets
-      if(info->index == 0){
-        // if(info->num == 0)
-        //   ppf("ws[%s][%u] %s-message start\n", ws.url(), client->id(), (info->message_opcode == WS_TEXT)?"text":"binary");
-        // ppf("ws[%s][%u] frame[%u] start[%llu]\n", ws.url(), client->id(), info->num, info->len);
-        ppf("💀");
+      //message is comprised of multiple frames or the frame is split into multiple packets: reassemble text messages
+      //  info->num: frame nr, info->index: offset of data in frame, info->len: frame length, info->final: last frame
+      if (info->message_opcode != WS_TEXT) return; //no binary commands
+
+      WsFragments &fragments = wsFragments[client->id()];
+      if (info->num == 0 && info->index == 0) { //message start
+        fragments.message.clear();
+        fragments.tooLarge = false;
       }
 
-      // ppf("ws[%s][%u] frame[%u] %s[%llu - %llu]: ", ws.url(), client->id(), info->num, (info->message_opcode == WS_TEXT)?"text":"binary", info->index, info->index + len);
-      ppf("💀");
-
-      if(info->opcode == WS_TEXT){
-        for (size_t i=0; i < len; i++) {
-          msg += (char) data[i];
+      if (!fragments.tooLarge) {
+        if (fragments.message.size() + len > WS_MAX_MESSAGE) {
+          fragments.tooLarge = true;
+          std::vector<byte>().swap(fragments.message); //release memory
         }
+        else
+          fragments.message.insert(fragments.message.end(), data, data + len);
       }
-      // else {
-      //   char buff[3];
-      //   for (size_t i=0; i < len; i++) {
-      //     sprintf(buff, "%02x ", (unsigned8) data[i]);
-      //     msg += buff ;
-      //   }
-      // }
-      ppf("%s\n",msg.c_str());
-
-      if ((info->index + len) == info->len) {
-        // ppf("ws[%s][%u] frame[%u] end[%llu]\n", ws.url(), client->id(), info->num, info->len);
-        ppf("👻");
-        if(info->final){
-          // ppf("ws[%s][%u] %s-message end\n", ws.url(), client->id(), (info->message_opcode == WS_TEXT)?"text":"binary");
-          ppf("☠️");
-          if(info->message_opcode == WS_TEXT)
-            client->text("I got your text message");
-          else
-            client->binary("I got your binary message");
+
+      if (info->final && (info->index + len) == info->len) { //message end
+        recvWsCounter++;
+        recvWsBytes+=fragments.message.size();
+        if (fragments.tooLarge) {
+          ppf("wsEvent message too large client %d (max %d)\n", client->id(), WS_MAX_MESSAGE);
+          client->text("{\"success\":false,\"error\":\"message too large\"}");
         }
+        else {
+          printClient("WS event data multi frame", client);
+          wsText(client, fragments.message.data(), fragments.message.size());
+        }
+        wsFragments.erase(client->id());
       }
-
-      //message is comprised of multiple frames or the frame is split into multiple packets
-      //if(info->index == 0){
-        //if (!wsFrameBuffer && len < 4096) wsFrameBuffer = new unsigned8[4096];
-      //}
-
-      //if (wsFrameBuffer && len < 4096 && info->index + info->)
-      //{
-
-      //}
-
-      // if((info->index + len) == info->len){
-      //   if(info->final){
-      //     if(info->message_opcode == WS_TEXT) {
-      //       client->text("{\"error\":9}"); //we do not handle split packets right now
-      //       ppf("WS multipart message: we do not handle split packets right now\n");
-      //     }
-      //   }
-      // }
-      // ppf("WS multipart message f:%d i:%d len:%d == %d\n", info->final, info->index, info->len, len);
     }
   } else if (type == WS_EVT_ERROR){
     //error was received from the other end
@@ -392,62 +975,278 @@ void SysModWeb::wsEvent(WebSocket * ws, WebClient * client, AwsEventType type, v
   }
 }
 
-void SysModWeb::sendDataWs(JsonVariant json, WebClient * client) {
+void SysModWeb::wsText(WebClient * client, byte *data, size_t len) {
+  if (len > 0 && len < 10 && data[0] == 'p') {
+    // application layer ping/pong heartbeat.
+    // client-side socket layer ping packets are unresponded (investigate)
+    // printClient("WS client pong", client); //crash?
+    ppf("pong\n");
+    client->text("pong");
+  } else {
+    JsonDocument *responseDoc = getResponseDoc(); //we need the doc for deserializeJson
+    JsonObject responseObject = getResponseObject();
+
+    DeserializationError error = deserializeJson(*responseDoc, data, len); //data to responseDoc
+
+    if (error || responseObject.isNull()) {
+      ppf("wsEvent deserializeJson failed with code %s\n", error.c_str());
+      client->text("{\"success\":true}"); // we have to send something back otherwise WS connection closes
+    } else {
+      if (responseObject["binary"] == true) { //client supports binary values: send var nrs, then binary
+        responseObject.remove("binary");
+        JsonDocument binaryVarsDoc;
+        xSemaphoreTake(mdl->modelMutex, portMAX_DELAY);
+        JsonArray binaryVars = binaryVarsDoc["binaryVars"].to<JsonArray>();
+        binaryVarsToJson(mdl->model->as<JsonArray>(), binaryVars);
+        sendDataWs(binaryVarsDoc.as<JsonObject>(), client);
+        if (!isBinaryClient(client)) binaryClients.push_back({client->id(), (unsigned16)binaryVars.size()});
+        xSemaphoreGive(mdl->modelMutex);
+        ppf("WS client %d binary values (%d vars)\n", client->id(), binaryVars.size());
+      }
+
+      if (!responseObject["subscribe"].isNull() || !responseObject["unsubscribe"].isNull())
+        channelCommand(client, responseObject);
+
+      if (!responseObject["visible"].isNull())
+        viewCommand(client, responseObject);
+
+      bool isOnUI = !responseObject["onUI"].isNull();
+      ui->processJson(responseObject); //adds to responseDoc / responseObject
+
+      if (responseObject.size()) {
+        sendResponseObject(isOnUI?client:nullptr); //onUI only send to requesting client async response
+      }
+      else {
+        ppf("WS_EVT_DATA no responseDoc\n");
+        client->text("{\"success\":true}"); // we have to send something back otherwise WS connection closes
+      }
+    }
+  }
+}
+
+unsigned8 SysModWeb::addChannel(const char * name, unsigned8 fps, bool lossy) {
+  if (WS_FIRST_CHANNEL + channels.size() >= WS_BINARY_VALUES) {
+    ppf("addChannel %s: too many channels\n", name);
+    return UINT8_MAX;
+  }
+  channels.push_back({name, max(fps, (unsigned8)1), lossy});
+  return WS_FIRST_CHANNEL + channels.size() - 1;
+}
+
+void SysModWeb::sendChannel(unsigned8 channelNr, std::function<void(byte *)> fill, size_t len) {
+  if (channelNr < WS_FIRST_CHANNEL || channelNr - WS_FIRST_CHANNEL >= channels.size()) return;
+  Channel &channel = channels[channelNr - WS_FIRST_CHANNEL];
+
+  //subscribed clients which are due for a new frame
+  std::vector<uint32_t> due;
+  unsigned long now = millis();
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  for (ChannelClient &channelClient: channel.clients) {
+    if (now - channelClient.lastMillis >= channelClient.interval) {
+      channelClient.lastMillis = now;
+      due.push_back(channelClient.id);
+    }
+  }
+  xSemaphoreGive(wsMutex);
+  if (due.empty()) return; //nobody watching (now): frame not made
+
+  sendDataWs([channelNr, &fill](AsyncWebSocketMessageBuffer * wsBuf) {
+    wsBuf->get()[0] = channelNr;
+    fill(wsBuf->get());
+  }, len, true, nullptr, [&due](WebClient * loopClient) {
+    return std::find(due.begin(), due.end(), loopClient->id()) != due.end();
+  }, channel.lossy);
+}
+
+void SysModWeb::channelCommand(WebClient * client, JsonObject command) {
+  JsonDocument channelsDoc;
+  JsonObject channelsObject = channelsDoc["channels"].to<JsonObject>(); //subscribed channel nrs, by name
+
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  for (unsigned8 index = 0; index < channels.size(); index++) {
+    Channel &channel = channels[index];
+    unsigned8 channelNr = WS_FIRST_CHANNEL + index;
+    auto it = channel.clients.begin();
+    while (it != channel.clients.end() && it->id != client->id()) ++it;
+
+    bool unsubscribe = command["unsubscribe"] == channel.name;
+    if (command["unsubscribe"].is<JsonArray>())
+      for (JsonVariant name: command["unsubscribe"].as<JsonArray>())
+        if (name == channel.name) unsubscribe = true;
+
+    if (unsubscribe) {
+      if (it != channel.clients.end()) channel.clients.erase(it);
+    }
+    else if (command["subscribe"][channel.name].is<unsigned8>()) {
+      unsigned8 fps = command["subscribe"][channel.name];
+      if (fps == 0 || fps > channel.fps) fps = channel.fps; //0: channel fps
+      if (it == channel.clients.end())
+        channel.clients.push_back({client->id(), (unsigned16)(1000 / fps), 0});
+      else
+        it->interval = 1000 / fps;
+      channelsObject[channel.name] = channelNr;
+    }
+  }
+  xSemaphoreGive(wsMutex);
+
+  command.remove("subscribe");
+  command.remove("unsubscribe");
+  if (channelsObject.size())
+    sendDataWs(channelsDoc.as<JsonObject>(), client);
+}
+
+void SysModWeb::invalidateModelCache() {
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  if (!moduleBlobs.empty()) {
+    for (ModuleBlob &blob: moduleBlobs)
+      if (blob.wsBuf) blob.wsBuf->unlock();
+    moduleBlobs.clear();
+    moduleBlobOfVar.clear();
+    ws._cleanBuffers(); //unlocked buffers are freed when all clients sent them
+  }
+  xSemaphoreGive(wsMutex);
+}
+
+void SysModWeb::modelValueChanged(const char * varId) {
+  uint32_t idHash = SysModModel::varIdHash(varId);
+  xSemaphoreTake(changedMutex, portMAX_DELAY);
+  if (!allValuesChanged && std::find(changedVars.begin(), changedVars.end(), idHash) == changedVars.end()) {
+    if (changedVars.size() < 32)
+      changedVars.push_back(idHash);
+    else
+      allValuesChanged = true; //too many to keep track of
+  }
+  xSemaphoreGive(changedMutex);
+}
+
+//serialized modules of values changed since the last connect are serialized again (under wsMutex)
+void SysModWeb::invalidateChangedModules() {
+  std::vector<uint32_t> vars;
+  xSemaphoreTake(changedMutex, portMAX_DELAY);
+  vars.swap(changedVars);
+  bool all = allValuesChanged;
+  allValuesChanged = false;
+  xSemaphoreGive(changedMutex);
+
+  if (moduleBlobs.empty() || (!all && vars.empty())) return;
+  for (forUnsigned8 blobNr = 0; blobNr < moduleBlobs.size(); blobNr++) {
+    ModuleBlob &blob = moduleBlobs[blobNr];
+    bool changed = all;
+    for (uint32_t idHash: vars) {
+      auto it = moduleBlobOfVar.find(idHash);
+      if (it != moduleBlobOfVar.end() && it->second == blobNr) changed = true;
+    }
+    if (changed && blob.wsBuf) {blob.wsBuf->unlock(); blob.wsBuf = nullptr;}
+  }
+  ws._cleanBuffers(); //unlocked buffers are freed when all clients sent them
+}
+
+void SysModWeb::sendDataWs(JsonVariant json, WebClient * client, std::function<bool(WebClient *)> filter) {
 
   size_t len = measureJson(json);
+  if (len > 8192) {
+    if (json.is<JsonObject>() && json.size() > 1) //in parts, each a valid json message
+      sendDataWsSplit(json, client, filter);
+    else
+      sendDataWsFragments(json, len, client, filter);
+    return;
+  }
   sendDataWs([json, len](AsyncWebSocketMessageBuffer * wsBuf) {
     serializeJson(json, wsBuf->get(), len);
-  }, len, false, client); //false -> text
+  }, len, false, client, filter); //false -> text
+}
+
+void SysModWeb::sendDataWsFragments(JsonVariant json, size_t len, WebClient * client, std::function<bool(WebClient *)> filter) {
+  char * text = (char *)malloc(len + 1); //+1: null terminator
+  if (!text) {
+    ppf("sendDataWsFragments allocation of %d bytes failed\n", len);
+    return;
+  }
+  serializeJson(json, text, len + 1);
+  ppf("dev sendDataWsFragments %d bytes\n", len);
+
+  xSemaphoreTake(fragmentMutex, portMAX_DELAY);
+  for (size_t offset = 0; offset < len; offset += WS_FRAGMENT_SIZE) {
+    size_t size = min(len - offset, (size_t)WS_FRAGMENT_SIZE);
+    byte flags = (offset == 0?1:0) | (offset + size == len?2:0);
+    sendDataWs([text, offset, size, flags](AsyncWebSocketMessageBuffer * wsBuf) {
+      wsBuf->get()[0] = WS_BINARY_FRAGMENT;
+      wsBuf->get()[1] = flags;
+      memcpy(wsBuf->get() + 2, text + offset, size);
+    }, size + 2, true, client, filter, false); //true -> binary, not lossy: a lost fragment loses the message
+  }
+  xSemaphoreGive(fragmentMutex);
+  free(text);
 }
 
 //https://kcwong-joe.medium.com/passing-a-function-as-a-parameter-in-c-a132e69669f6
-void SysModWeb::sendDataWs(std::function<void(AsyncWebSocketMessageBuffer *)> fill, size_t len, bool isBinary, WebClient * client) {
+void SysModWeb::sendDataWs(std::function<void(AsyncWebSocketMessageBuffer *)> fill, size_t len, bool isBinary, WebClient * client, std::function<bool(WebClient *)> filter, bool lossy) {
 
+  //wsMutex only around the ws administration, not while filling the buffer
   xSemaphoreTake(wsMutex, portMAX_DELAY);
-
   ws.cleanupClients(); //only if above threshold
+  if (!ws.count()) {
+    xSemaphoreGive(wsMutex);
+    return;
+  }
+  if (len > 8192)
+    ppf("dev sendDataWs large message %d\n", len); //send as one frame, not from the pool
 
-  if (ws.count()) {
-    if (len > 8192)
-      ppf("program error: sendDataWs BufferLen too high !!!%d\n", len);
-    AsyncWebSocketMessageBuffer * wsBuf = ws.makeBuffer(len); //assert failed: block_trim_free heap_tlsf.c:371 (block_is_free(block) && "block must be free"), AsyncWebSocket::makeBuffer(unsigned int)
-
-    if (wsBuf) {
-      wsBuf->lock();
-
-      fill(wsBuf); //function parameter
-
-      for (auto loopClient:ws.getClients()) {
-        if (!client || client == loopClient) {
-          if (loopClient->status() == WS_CONNECTED && !loopClient->queueIsFull()) { //WS_MAX_QUEUED_MESSAGES / ws.count() / 2)) { //binary is lossy
-            if (!isBinary || loopClient->queueLength() <= 3) {
-              isBinary?loopClient->binary(wsBuf): loopClient->text(wsBuf);
-              sendWsCounter++;
-              if (isBinary)
-                sendWsBBytes+=len;
-              else 
-                sendWsTBytes+=len;
-            }
-          }
-          else {
-            printClient("sendDataWs client full or not connected", loopClient);
-            // ppf("sendDataWs client full or not connected\n");
-            ws.cleanupClients(); //only if above threshold
-            ws._cleanBuffers();
-          }
-        }
-      }
-      wsBuf->unlock();
-      ws._cleanBuffers();
-    }
-    else {
+  AsyncWebSocketMessageBuffer * wsBuf;
+  PoolBuffer * poolBuffer = wsPoolGet(ws, len);
+  if (poolBuffer)
+    wsBuf = poolBuffer->wsBuf;
+  else {
+    wsPoolMisses++;
+    wsBuf = ws.makeBuffer(len); //assert failed: block_trim_free heap_tlsf.c:371 (block_is_free(block) && "block must be free"), AsyncWebSocket::makeBuffer(unsigned int)
+    if (!wsBuf) {
       ppf("sendDataWs WS buffer allocation failed\n");
       ws.closeAll(1013); //code 1013 = temporary overload, try again later
       ws.cleanupClients(0); //disconnect ALL clients to release memory
       ws._cleanBuffers();
+      xSemaphoreGive(wsMutex);
+      return;
     }
+    wsBuf->lock(); //not cleaned until unlocked
   }
+  xSemaphoreGive(wsMutex);
+
+  fill(wsBuf); //function parameter, buffer is only ours until queued
 
+  //the client list is changed by the ws lib (connect, cleanupClients): wsMutex while walking it, queueing is quick
+  //  filters must not take wsMutex
+  xSemaphoreTake(wsMutex, portMAX_DELAY);
+  bool cleanup = false;
+  for (auto loopClient:ws.getClients()) {
+    if ((!client || client == loopClient) && (!filter || filter(loopClient))) {
+      if (loopClient->status() == WS_CONNECTED && !loopClient->queueIsFull()) { //WS_MAX_QUEUED_MESSAGES / ws.count() / 2)) { //binary is lossy
+        if (!isBinary || !lossy || loopClient->queueLength() <= 3) {
+          isBinary?loopClient->binary(wsBuf): loopClient->text(wsBuf);
+          sendWsCounter++;
+          if (isBinary)
+            sendWsBBytes+=wsBuf->length();
+          else 
+            sendWsTBytes+=wsBuf->length();
+        }
+      }
+      else {
+        printClient("sendDataWs client full or not connected", loopClient);
+        // ppf("sendDataWs client full or not connected\n");
+        cleanup = true;
+      }
+    }
+  }
+  if (cleanup) { //not while walking the client list
+    ws.cleanupClients(); //only if above threshold
+    ws._cleanBuffers();
+  }
+
+  if (poolBuffer)
+    poolBuffer->inUse = false; //reused when all clients sent it
+  else {
+    wsBuf->unlock();
+    ws._cleanBuffers();
+  }
   xSemaphoreGive(wsMutex);
 }
 
@@ -458,12 +1257,13 @@ void SysModWeb::serveIndex(WebRequest *request) {
 
   if (captivePortal(request)) return;
 
-  // if (handleIfNoneMatchCacheHeader(request)) return;
+  if (notModified(request, indexETag)) return;
 
   WebResponse *response;
   response = request->beginResponse_P(200, "text/html", PAGE_index, PAGE_index_L);
   response->addHeader("Content-Encoding","gzip");
-  // setStaticContentCacheHeaders(response);
+  response->addHeader("Cache-Control", "no-cache"); //cached, but revalidated (304) on each load
+  response->addHeader("ETag", indexETag);
   request->send(response);
 
   ppf("!\n");
@@ -549,8 +1349,55 @@ void SysModWeb::serveFiles(WebRequest *request) {
   const char * urlString = request->url().c_str();
   const char * path = urlString + strlen("/file"); //remove the uri from the path (skip their positions)
   ppf("fileServer request %s\n", path);
-  if(LittleFS.exists(path)) {
-    request->send(LittleFS, path, "text/plain");//"application/json");
+
+  //precompressed variant if the browser accepts it
+  char gzPath[64];
+  snprintf(gzPath, sizeof(gzPath), "%s.gz", path);
+  bool gzip = request->hasHeader("Accept-Encoding") && strstr(request->header("Accept-Encoding").c_str(), "gzip") && LittleFS.exists(gzPath);
+  const char * filePath = gzip?gzPath:path;
+
+  File file = LittleFS.open(filePath);
+  if (!file || file.isDirectory()) {
+    request->send(404);
+    return;
+  }
+  //file changes on upload / save: size and last write
+  char eTag[32];
+  snprintf(eTag, sizeof(eTag), "\"%x-%lx%s\"", file.size(), (unsigned long)file.getLastWrite(), gzip?"-gz":"");
+  file.close();
+
+  if (notModified(request, eTag)) return;
+
+  WebResponse *response = request->beginResponse(LittleFS, filePath, contentType(path));
+  if (gzip) response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("Cache-Control", "no-cache"); //cached, but revalidated (304) on each request
+  response->addHeader("ETag", eTag);
+  response->addHeader("Vary", "Accept-Encoding");
+  request->send(response);
+}
+
+bool SysModWeb::notModified(WebRequest *request, const char * eTag) {
+  if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == eTag) {
+    WebResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", eTag);
+    request->send(response);
+    return true;
+  }
+  return false;
+}
+
+//keys of a command which are no command and no var
+static void unknownKeys(JsonObject command, JsonArray unknown) {
+  for (JsonPair pair: command) {
+    const char * key = pair.key().c_str();
+    if (strcmp(key, "v") == 0 || strcmp(key, "view") == 0 || strcmp(key, "canvasData") == 0 || strcmp(key, "theme") == 0
+        || strcmp(key, "addRow") == 0 || strcmp(key, "delRow") == 0 || strcmp(key, "onUI") == 0)
+      continue;
+    char id[32];
+    strlcpy(id, key, sizeof(id));
+    char * rowNrC = strchr(id, '#');
+    if (rowNrC) *rowNrC = '\0';
+    if (mdl->findVar(id).isNull()) unknown.add(key);
   }
 }
 
@@ -560,25 +1407,68 @@ void SysModWeb::jsonHandler(WebRequest *request, JsonVariant json) {
 
   JsonObject responseObject = getResponseObject();
 
-  ui->processJson(json);
+  bool changedOnly = request->hasParam("changed"); //only the values which changed: {"id":{"value":..}} or {"id":{"cells":..}}
+
+  JsonDocument resultsDoc; //per command status if an array of commands
+  JsonArray results = resultsDoc.to<JsonArray>();
+
+  if (json.is<JsonArray>()) { //array of commands, executed as one batch
+    mdl->beginBatch();
+    for (JsonVariant command: json.as<JsonArray>()) {
+      JsonObject result = results.add<JsonObject>();
+      if (!command.is<JsonObject>()) {
+        result["success"] = false;
+        result["error"] = "not an object";
+        continue;
+      }
+      JsonArray unknown = result["unknown"].to<JsonArray>();
+      unknownKeys(command, unknown); //before processJson, as it changes keys with a rowNr
+      if (!unknown.size()) result.remove("unknown");
+      result["success"] = ui->processJson(command); //false if unknown or a command failed
+    }
+    mdl->commitBatch(); //change functions run after all values are set, their responses included
+  }
+  bool success = json.is<JsonArray>() || ui->processJson(json);
 
   //WLED compatibility
   if (json["v"]) { //WLED compatibility: verbose response
     serveJson (request); //includes values just updated by processJson e.g. Bri
   }
   else {
-  
-    if (responseObject.size()) { //responseObject set by processJson e.g. onUI
-
-      char resStr[200];
-      serializeJson(responseObject, resStr, 200);
-      ppf("processJsonUrl response %s\n", resStr);
-      request->send(200, "application/json", resStr);
-
+    //any size, serialized from results and responseObject straight into the response (no copy)
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    bool first = true;
+    response->print("{");
+    if (results.size()) {
+      response->print("\"results\":");
+      serializeJson(results, *response);
+      first = false;
     }
-    else
-      // request->send(200, "text/plain", "OK");
-      request->send(200, "application/json", F("{\"success\":true}"));
+    for (JsonPair pair: responseObject) { //responseObject set by processJson e.g. onUI and values
+      JsonVariant value = pair.value();
+      if (changedOnly && (!value.is<JsonObject>() || (value["value"].isNull() && value["cells"].isNull())))
+        continue;
+      response->printf("%s\"%s\":", first?"":",", pair.key().c_str());
+      first = false;
+      if (!changedOnly)
+        serializeJson(value, *response);
+      else {
+        response->print("{");
+        if (!value["value"].isNull()) {
+          response->print("\"value\":");
+          serializeJson(value["value"], *response);
+        }
+        if (!value["cells"].isNull()) {
+          response->print(value["value"].isNull()?"\"cells\":":",\"cells\":");
+          serializeJson(value["cells"], *response);
+        }
+        response->print("}");
+      }
+    }
+    if (first) response->print(success?"\"success\":true":"\"success\":false");
+    response->print("}");
+    ppf("processJsonUrl response %d results %d vars\n", results.size(), responseObject.size());
+    request->send(response);
   }
 
   sendResponseObject();
@@ -622,7 +1512,19 @@ bool SysModWeb::captivePortal(WebRequest *request)
 JsonDocument * SysModWeb::getResponseDoc() {
   // ppf("response wsevent core %d %s\n", xPortGetCoreID(), pcTaskGetTaskName(NULL));
 
-  return strncmp(pcTaskGetTaskName(NULL), "loopTask", 8) == 0?responseDocLoopTask:responseDocAsyncTCP;
+  return taskResponseDoc?taskResponseDoc:registerResponseDoc();
+}
+
+JsonDocument * SysModWeb::registerResponseDoc() {
+  if (!taskResponseDoc) {
+    taskResponseDoc = new JsonDocument; taskResponseDoc->to<JsonObject>();
+  }
+  return taskResponseDoc;
+}
+
+void SysModWeb::unregisterResponseDoc() {
+  delete taskResponseDoc;
+  taskResponseDoc = nullptr;
 }
 
 JsonObject SysModWeb::getResponseObject() {
@@ -650,7 +1552,92 @@ void SysModWeb::sendResponseObject(WebClient * client) {
     //   }
     //   ppf("\n");
     // }
-    sendDataWs(responseObject, client);
+
+    //clients which can not keep up (queue full or already waiting): in their outbox, flushed in loop20ms
+    //  the others are grouped by view (modules shown, broadcasts only, not the response to a client request), so the
+    //  vars of a view are filtered once and encoded once for the binary clients and once as json for the others
+    struct Audience {
+      std::vector<uint32_t> view; //empty: all modules
+      std::vector<uint32_t> jsonClients;
+      std::vector<uint32_t> binaryClients;
+      unsigned16 knownVars = UINT16_MAX; //only vars all binary clients of the audience know
+    };
+    std::vector<Audience> audiences;
+    xSemaphoreTake(wsMutex, portMAX_DELAY);
+    for (auto loopClient:ws.getClients()) {
+      if ((!client || client == loopClient) && loopClient->status() == WS_CONNECTED) {
+        auto view = client?clientViews.end():clientViews.find(loopClient->id());
+        if (loopClient->queueIsFull() || outboxes.count(loopClient->id())) { //waiting
+          JsonDocument viewDoc;
+          JsonObject clientObject = responseObject;
+          if (view != clientViews.end()) {
+            clientObject = viewDoc.to<JsonObject>();
+            for (JsonPair pair: responseObject)
+              if (inView(view->second, pair.key().c_str())) clientObject[pair.key()] = pair.value();
+          }
+          JsonDocument &outbox = outboxes[loopClient->id()];
+          if (!outbox.is<JsonObject>()) outbox.to<JsonObject>();
+          mergeIntoOutbox(outbox.as<JsonObject>(), clientObject);
+          if (outbox.overflowed()) { //no memory to keep up: reconnect gets the whole model
+            ppf("sendResponseObject outbox overflow client %d\n", loopClient->id());
+            outboxes.erase(loopClient->id());
+            loopClient->close();
+          }
+          continue;
+        }
+
+        std::vector<uint32_t> clientView; //empty: all modules
+        if (view != clientViews.end()) clientView = view->second;
+        auto audience = audiences.begin();
+        while (audience != audiences.end() && audience->view != clientView) ++audience;
+        if (audience == audiences.end()) {
+          audiences.push_back(Audience());
+          audience = audiences.end() - 1;
+          audience->view = clientView;
+        }
+        bool binary = false;
+        for (auto &binaryClient: binaryClients)
+          if (binaryClient.first == loopClient->id()) {
+            binary = true;
+            audience->knownVars = min(audience->knownVars, binaryClient.second);
+          }
+        (binary?audience->binaryClients:audience->jsonClients).push_back(loopClient->id());
+      }
+    }
+    xSemaphoreGive(wsMutex);
+
+    for (Audience &audience: audiences) {
+      JsonDocument viewDoc;
+      JsonObject audienceObject = responseObject;
+      if (!audience.view.empty()) {
+        audienceObject = viewDoc.to<JsonObject>();
+        xSemaphoreTake(wsMutex, portMAX_DELAY); //moduleBlobOfVar
+        for (JsonPair pair: responseObject)
+          if (inView(audience.view, pair.key().c_str())) audienceObject[pair.key()] = pair.value();
+        xSemaphoreGive(wsMutex);
+      }
+      if (!audienceObject.size()) continue;
+
+      if (audience.jsonClients.size())
+        sendDataWs(audienceObject, client, [&audience](WebClient * loopClient) {
+          return std::find(audience.jsonClients.begin(), audience.jsonClients.end(), loopClient->id()) != audience.jsonClients.end();
+        });
+      if (audience.binaryClients.size()) {
+        std::vector<byte> frame;
+        JsonDocument restDoc;
+        encodeBinaryValues(audienceObject, audience.knownVars, frame, restDoc);
+
+        auto inAudience = [&audience](WebClient * loopClient) {
+          return std::find(audience.binaryClients.begin(), audience.binaryClients.end(), loopClient->id()) != audience.binaryClients.end();
+        };
+        if (frame.size() > 1)
+          sendDataWs([&frame](AsyncWebSocketMessageBuffer * wsBuf) {
+            memcpy(wsBuf->get(), frame.data(), frame.size());
+          }, frame.size(), true, client, inAudience, false); //values are not lossy
+        if (restDoc.size())
+          sendDataWs(restDoc.as<JsonObject>(), client, inAudience);
+      }
+    }
     getResponseDoc()->to<JsonObject>(); //recreate!
   }
 }
@@ -694,13 +1681,37 @@ void SysModWeb::serveJson(WebRequest *request) {
 
   // return model.json
   if (request->url().indexOf("mdl") > 0) {
-    JsonArray model = mdl->model->as<JsonArray>();
-    ppf("serveJson model ...%d, %s %d %d\n", request->client()->remoteIP()[3], request->url().c_str(), model.size(),  measureJson(model));
-
-    response = new AsyncJsonResponse(true); //array, removed size as ArduinoJson v7 doesnt care (tbd: here copy is mode, see WLED for using reference)
-    JsonArray root = response->getRoot();
-
-    root.set(model);
+    ppf("serveJson model ...%d, %s %d\n", request->client()->remoteIP()[3], request->url().c_str(), mdl->model->as<JsonArray>().size());
+
+    //no copy of the whole model: the loop task serializes a part of the model at a time between loops (see ModelStream),
+    //  if it is not ready the callback asks the server to try again later (async_tcp is not blocked)
+    std::shared_ptr<ModelStream> stream = std::make_shared<ModelStream>();
+    request->send(request->beginChunkedResponse("application/json", [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t len = 0;
+      while (len < maxLen) {
+        unsigned8 state = stream->state;
+        if (state == ModelStream::idle) {
+          stream->state = ModelStream::requested;
+          mdls->runInLoop([stream]() {
+            stream->fill(mdl->model->as<JsonArray>());
+          });
+        }
+        else if (state == ModelStream::ready || state == ModelStream::last) {
+          size_t sliceLength = min(maxLen - len, stream->length - stream->offset);
+          memcpy(buffer + len, stream->snapshot + stream->offset, sliceLength);
+          len += sliceLength;
+          stream->offset += sliceLength;
+          if (stream->offset == stream->length) {
+            stream->offset = 0;
+            stream->state = (state == ModelStream::last)?ModelStream::done:ModelStream::idle;
+          }
+        }
+        else break; //requested (not ready yet) or done
+      }
+      if (!len && stream->state != ModelStream::done) return RESPONSE_TRY_AGAIN; //snapshot not ready yet
+      return len;
+    }));
+    return;
   } else { //WLED compatible
     ppf("serveJson ...%d, %s\n", request->client()->remoteIP()[3], request->url().c_str());
     response = new AsyncJsonResponse(false); //object. removed size as ArduinoJson v7 doesnt care
@@ -711,6 +1722,13 @@ void SysModWeb::serveJson(WebRequest *request) {
     if (request->url().indexOf("state") > 0) {
       serializeState(root);
     }
+    #ifdef STARBASE_LOOP_PROFILE
+    else if (request->url().indexOf("profile") > 0) {
+      xSemaphoreTake(mdl->modelMutex, portMAX_DELAY); //profiles are updated by the loop task
+      mdls->profileToJson(root);
+      xSemaphoreGive(mdl->modelMutex);
+    }
+    #endif
     else if (request->url().indexOf("info") > 0) {
       serializeInfo(root);
     }
@@ -56,6 +56,7 @@ public:
   unsigned16 sendUDPBytes = 0;
   unsigned8 recvUDPCounter = 0;
   unsigned16 recvUDPBytes = 0;
+  unsigned16 wsConnects = 0; //incremented on each ws connect, e.g. to resend UI only values
 
   SysModWeb();
 
@@ -68,14 +69,29 @@ public:
   void connectedChanged();
 
   void wsEvent(WebSocket * ws, WebClient * client, AwsEventType type, void * arg, byte *data, size_t len);
+  //process a complete text message (json command or ping)
+  void wsText(WebClient * client, byte *data, size_t len);
   
-  //send json to client or all clients
-  void sendDataWs(JsonVariant json = JsonVariant(), WebClient * client = nullptr);
-  void sendDataWs(std::function<void(AsyncWebSocketMessageBuffer *)> fill, size_t len, bool isBinary, WebClient * client = nullptr);
+  //serialized modules for ws connects are out of date: all (structure changed: vars added or removed)
+  void invalidateModelCache();
+  //value of varId changed: only recorded, its module is serialized again on the next ws connect
+  void modelValueChanged(const char * varId);
+
+  //send json to client or all clients (filter: only clients for which it returns true)
+  void sendDataWs(JsonVariant json = JsonVariant(), WebClient * client = nullptr, std::function<bool(WebClient *)> filter = nullptr);
+  //lossy: binary is not send to clients with more than 3 messages queued
+  void sendDataWs(std::function<void(AsyncWebSocketMessageBuffer *)> fill, size_t len, bool isBinary, WebClient * client = nullptr, std::function<bool(WebClient *)> filter = nullptr, bool lossy = true);
+
+  //binary stream of a module: clients subscribe with {"subscribe":{"name":fps}} (0: channel fps) and {"unsubscribe":"name" or [names]}
+  //  frames go only to subscribed clients, at most at their fps. lossy: skip frames for clients with more than 3 messages queued
+  //  returns the channel nr (100..249, below are app frame ids), UINT8_MAX if no channel left
+  unsigned8 addChannel(const char * name, unsigned8 fps = 30, bool lossy = true);
+  //fill is only called if a subscribed client is due, buffer[0] is the channel nr, len includes it
+  void sendChannel(unsigned8 channelNr, std::function<void(byte *)> fill, size_t len);
 
   //add an url to the webserver to listen to
   void serveIndex(WebRequest *request);
-  //mdl and WLED style state and info
+  //mdl, profile (STARBASE_LOOP_PROFILE) and WLED style state and info
   void serializeState(JsonObject root);
   void serializeInfo(JsonObject root);
   void serveJson(WebRequest *request);
@@ -85,7 +101,10 @@ public:
   void serveUpload(WebRequest *request, const String& filename, size_t index, byte *data, size_t len, bool final);
   // curl -s -F "update=@/Users/ewoudwijma/Developer/GitHub/ewowi/StarBase/.pio/build/esp32dev/firmware.bin" 192.168.8.102/update /dev/null &
   void serveUpdate(WebRequest *request, const String& filename, size_t index, byte *data, size_t len, bool final);
+  //files from LittleFS with their content type, the .gz variant if it exists and the browser accepts it
   void serveFiles(WebRequest *request);
+  //answer 304 Not Modified if the browser has eTag already
+  bool notModified(WebRequest *request, const char * eTag);
 
   //processJsonUrl handles requests send in javascript using fetch and from a browser or curl
   //try this !!!: curl -X POST "http://192.168.121.196/json" -d '{"pin2":false}' -H "Content-Type: application/json"
@@ -94,6 +113,10 @@ public:
   //curl -X POST "http://192.168.8.125/json" -d '{"fx":2}' -H "Content-Type: application/json"
   //curl -X POST "http://192.168.8.152/json" -d '{"nrOfLeds":2000}' -H "Content-Type: application/json"
 
+  //curl -X POST "http://4.3.2.1/json?changed" -d '[{"bri":20}, {"fx":2}]' -H "Content-Type: application/json"
+  //  array: commands executed as one batch, response has "results" with the status per command
+  //  changed: only the changed values in the response
+
   //handle "v" and processJson (on /json)
   void jsonHandler(WebRequest *request, JsonVariant json);
 
@@ -123,6 +146,14 @@ public:
     }
   }
 
+  //changed cell of a table column: {"id":{"cells":{"rowNr":value}}} (instead of the whole column)
+  template <typename Type>
+  void addResponseCell(const char * id, unsigned8 rowNr, Type value) {
+    char rowNrS[4];
+    snprintf(rowNrS, sizeof(rowNrS), "%d", rowNr);
+    getResponseObject()[id]["cells"][rowNrS] = value; //char[] key: copied
+  }
+
   JsonArray addResponseA(const char * id, const char * key) {
     JsonObject responseObject = getResponseObject();
     // if (responseObject[id].isNull()) responseObject[id].to<JsonObject>();;
@@ -147,10 +178,17 @@ public:
 
   void clientsToJson(JsonArray array, bool nameOnly = false, const char * filter = nullptr);
 
-  //gets the right responseDoc, depending on which task you are in, alternative for requestJSONBufferLock
+  //gets the responseDoc of the task you are in (created on first use), alternative for requestJSONBufferLock
   JsonDocument * getResponseDoc();
+  //give the current task its own responseDoc, e.g. at the start of a script or sensor task
+  JsonDocument * registerResponseDoc();
+  //free the responseDoc of the current task, call before the task deletes itself
+  void unregisterResponseDoc();
   JsonObject getResponseObject();
+  //clients with a full queue get var updates coalesced in an outbox (latest value wins) instead of dropped
   void sendResponseObject(WebClient * client = nullptr);
+  //send outboxes of clients which drained their queue (loop20ms)
+  void flushOutboxes();
 
   void printClient(const char * text, WebClient * client) {
     ppf("%s client: %d ...%d q:%d l:%d s:%d (#:%d)\n", text, client?client->id():-1, client?client->remoteIP()[3]:-1, client->queueIsFull(), client->queueLength(), client->status(), client->server()->count());
@@ -160,10 +198,26 @@ public:
 private:
   bool modelUpdated = false;
 
+  //handle subscribe / unsubscribe of a client, answers {"channels":{"name":nr}}
+  void channelCommand(WebClient * client, JsonObject command);
+  //modules shown by a client: {"visible":[module ids]} or {"visible":true} for all, answers values of modules shown again
+  void viewCommand(WebClient * client, JsonObject command);
+  //send json in messages under the websocket size limit of 8192 (split on the top level keys)
+  //  unsent (one client): from the first message the queue of client is full, the messages are added to unsent instead
+  void sendDataWsSplit(JsonObject json, WebClient * client = nullptr, std::function<bool(WebClient *)> filter = nullptr, JsonObject unsent = JsonObject());
+  //send json which is over the size limit and can not be split (no object or one key) as binary fragments, reassembled by the client
+  void sendDataWsFragments(JsonVariant json, size_t len, WebClient * client = nullptr, std::function<bool(WebClient *)> filter = nullptr);
+  SemaphoreHandle_t fragmentMutex = xSemaphoreCreateMutex(); //fragments of one message are not mixed with those of another
+
   bool clientsChanged = false;
 
-  JsonDocument *responseDocLoopTask = nullptr;
-  JsonDocument *responseDocAsyncTCP = nullptr;
+  //vars of which the value changed since the last connect (id hashes), see modelValueChanged
+  SemaphoreHandle_t changedMutex = xSemaphoreCreateMutex();
+  std::vector<uint32_t> changedVars;
+  bool allValuesChanged = false; //more than 32 vars changed
+  void invalidateChangedModules();
+  //clTbl rows from the current ws clients
+  void updateClientRows();
 
 };
 
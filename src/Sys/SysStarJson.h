@@ -39,6 +39,17 @@ class StarJson {
     files->filesChanged = true;
   }
 
+  //serializeMsgPack (with exclusions), optional header bytes written before the MessagePack data
+  //returns false if a variant type is not supported: the file is incomplete and should not be used
+  bool writeMsgPackDocToFile(JsonDocument* dest, const byte * header = nullptr, size_t headerLength = 0) {
+    msgPackUnsupported = false;
+    if (header) f.write(header, headerLength);
+    writeMsgPackVariantToFile(dest->as<JsonVariant>());
+    f.close();
+    files->filesChanged = true;
+    return !msgPackUnsupported;
+  }
+
   //look for uint8 var
   // void lookFor(const char * id, unsigned8 * value) {
   //   // const char *p = (const char*)&value; //pointer trick
@@ -99,6 +110,7 @@ private:
   char beforeLastVarId[128] = ""; //last found var id in json
   size_t foundCounter = 0; //count how many of the id's to lookFor have been actually found
   bool foundAll = false;
+  bool msgPackUnsupported = false; //writeMsgPackVariantToFile met a variant type it cannot write
 
   //called by lookedFor, store the var details in varDetails
   void addToVars(const char * id, const char * type, size_t index) {
@@ -233,24 +245,27 @@ private:
     foundAll = foundCounter >= varDetails.size();
   }
 
+  bool isExcluded(const char * key) {
+    for (char *el:charList) {
+      if (strcmp(el, key)==0)
+        return true;
+    }
+    return false;
+  }
+
   //writeJsonVariantToFile calls itself recursively until whole json document has been parsed
   void writeJsonVariantToFile(JsonVariant variant) {
     if (variant.is<JsonObject>()) {
       f.printf("{");
       char sep[2] = "";
       for (JsonPair pair: variant.as<JsonObject>()) {
-        bool found = false;
-        for (char *el:charList) {
-          if (strcmp(el, pair.key().c_str())==0) {
-            found = true;
-            break;
-          }
-        }
-        // std::vector<char *>::iterator itr = find(charList.begin(), charList.end(), pair.key().c_str());
-        if (!found) { //not found
+        if (!isExcluded(pair.key().c_str())) {
           f.printf("%s\"%s\":", sep, pair.key().c_str());
           strcpy(sep, ",");
-          writeJsonVariantToFile(pair.value());
+          if (pair.key() == "type" && pair.value().is<unsigned8>() && pair.value().as<unsigned8>() < t_count) //var type as name
+            f.printf("\"%s\"", varTypeInfo[pair.value().as<unsigned8>()].name);
+          else
+            writeJsonVariantToFile(pair.value());
         }
       }
       f.printf("}");
@@ -281,4 +296,110 @@ private:
       ppf("dev StarJson write %s not supported\n", variant.as<String>().c_str());
   }
 
+  //MessagePack: https://github.com/msgpack/msgpack/blob/master/spec.md, numbers are big endian
+  void writeMsgPackNumber(uint32_t value, size_t bytes) {
+    byte buffer[4];
+    for (size_t i = 0; i < bytes; i++)
+      buffer[i] = value >> (8 * (bytes - 1 - i));
+    f.write(buffer, bytes);
+  }
+
+  //fix: size in the first byte (fixmap, fixarray, fixstr), else 16 or 32 bits size
+  void writeMsgPackSize(byte fix, size_t fixMax, byte code16, size_t size) {
+    if (size <= fixMax)
+      f.write((byte)(fix | size));
+    else if (size <= UINT16_MAX) {
+      f.write(code16);
+      writeMsgPackNumber(size, 2);
+    }
+    else {
+      f.write((byte)(code16 + 1));
+      writeMsgPackNumber(size, 4);
+    }
+  }
+
+  void writeMsgPackString(const char * value) {
+    size_t len = strlen(value);
+    if (len < 32)
+      f.write((byte)(0xa0 | len));
+    else if (len <= UINT8_MAX) {
+      f.write((byte)0xd9);
+      f.write((byte)len);
+    }
+    else if (len <= UINT16_MAX) {
+      f.write((byte)0xda);
+      writeMsgPackNumber(len, 2);
+    }
+    else {
+      f.write((byte)0xdb);
+      writeMsgPackNumber(len, 4);
+    }
+    f.write((const byte *)value, len);
+  }
+
+  //writeMsgPackVariantToFile calls itself recursively, same exclusions as writeJsonVariantToFile
+  void writeMsgPackVariantToFile(JsonVariant variant) {
+    if (variant.is<JsonObject>()) {
+      size_t size = 0;
+      for (JsonPair pair: variant.as<JsonObject>())
+        if (!isExcluded(pair.key().c_str())) size++;
+      writeMsgPackSize(0x80, 15, 0xde, size);
+      for (JsonPair pair: variant.as<JsonObject>()) {
+        if (!isExcluded(pair.key().c_str())) {
+          writeMsgPackString(pair.key().c_str());
+          writeMsgPackVariantToFile(pair.value());
+        }
+      }
+    }
+    else if (variant.is<JsonArray>()) {
+      writeMsgPackSize(0x90, 15, 0xdc, variant.as<JsonArray>().size());
+      for (JsonVariant variant2: variant.as<JsonArray>())
+        writeMsgPackVariantToFile(variant2);
+    }
+    else if (variant.is<const char *>()) {
+      writeMsgPackString(variant.as<const char *>());
+    }
+    else if (variant.is<bool>()) {
+      f.write((byte)(variant.as<bool>()?0xc3:0xc2));
+    }
+    else if (variant.is<int32_t>()) {
+      int32_t value = variant;
+      if (value >= 0 && value < 128)
+        f.write((byte)value); //positive fixint
+      else if (value < 0 && value >= -32)
+        f.write((byte)value); //negative fixint
+      else if (value >= INT8_MIN && value <= INT8_MAX) {
+        f.write((byte)0xd0);
+        writeMsgPackNumber(value, 1);
+      }
+      else if (value >= INT16_MIN && value <= INT16_MAX) {
+        f.write((byte)0xd1);
+        writeMsgPackNumber(value, 2);
+      }
+      else {
+        f.write((byte)0xd2);
+        writeMsgPackNumber(value, 4);
+      }
+    }
+    else if (variant.is<uint32_t>()) {
+      f.write((byte)0xce);
+      writeMsgPackNumber(variant.as<uint32_t>(), 4);
+    }
+    else if (variant.is<double>()) { //float64: no precision lost (ArduinoJson stores doubles)
+      double value = variant;
+      uint64_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      f.write((byte)0xcb);
+      writeMsgPackNumber(bits >> 32, 4);
+      writeMsgPackNumber(bits & UINT32_MAX, 4);
+    }
+    else if (variant.isNull()) {
+      f.write((byte)0xc0);
+    }
+    else {
+      ppf("dev StarJson write msgpack %s not supported\n", variant.as<String>().c_str());
+      msgPackUnsupported = true; //nothing written for it, so the rest would be read wrong
+    }
+  }
+
 };
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+   @title     StarBase
+   @file      SysVarIndex.h
+   @date      20240411
+   @repo      https://github.com/ewowi/StarBase, submit changes to this file as PRs to ewowi/StarBase
+   @Authors   https://github.com/ewowi/StarBase/commits/main
+   @Copyright © 2024 Github StarBase Commit Authors
+   @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+   @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+*/
+
+#pragma once
+
+//only ArduinoJson and std: also used by the host benchmark (test/test_findvar)
+#include "ArduinoJson.h"
+
+#include <unordered_map>
+#include <vector>
+
+//entry in the var index (see findVar), parentVar is null for module vars
+struct VarIndexEntry {
+  JsonObject var;
+  JsonObject parentVar;
+};
+
+//id hash -> vars, so findVar costs the same whatever the size of the model
+//  ids with the same hash each have their own entry, entries are validated on lookup (id compare)
+//  not thread safe: SysModModel locks it (varIndexMutex)
+class VarIndex {
+public:
+
+  static uint32_t hash(const char * id) {
+    uint32_t hash = 2166136261; //FNV-1a
+    while (id && *id) {
+      hash ^= (uint8_t)*id++;
+      hash *= 16777619;
+    }
+    return hash;
+  }
+
+  //copy of the entry of id (hash and id equal), false if none
+  bool find(const char * id, VarIndexEntry &found) {
+    VarIndexEntry * entry = findEntry(id);
+    if (entry) found = *entry;
+    return entry != nullptr;
+  }
+
+  //a var with the same id in the index is replaced: new var wins from a var with the same id in a different parent
+  void add(JsonObject var, JsonObject parentVar) {
+    const char * id = var["id"];
+    if (!id) return;
+    VarIndexEntry * entry = findEntry(id);
+    if (entry)
+      *entry = {var, parentVar};
+    else
+      entries.emplace(hash(id), VarIndexEntry{var, parentVar});
+  }
+
+  //all vars of vars and their children, same id twice: the later one wins (as a new var in initVar)
+  void addAll(JsonArray vars, JsonObject parentVar = JsonObject()) {
+    for (JsonObject var : vars) {
+      add(var, parentVar);
+      if (!var["n"].isNull())
+        addAll(var["n"], var);
+    }
+  }
+
+  void clear() {entries.clear();}
+  size_t size() {return entries.size();}
+
+  //ids of all vars in the index
+  void ids(std::vector<const char *> &ids) {
+    for (auto &entry: entries)
+      if (!entry.second.var.isNull()) ids.push_back(entry.second.var["id"]);
+  }
+
+private:
+  std::unordered_multimap<uint32_t, VarIndexEntry> entries;
+
+  VarIndexEntry * findEntry(const char * id) {
+    auto range = entries.equal_range(hash(id));
+    for (auto it = range.first; it != range.second; ++it)
+      if (!it->second.var.isNull() && it->second.var["id"] == id) return &it->second;
+    return nullptr;
+  }
+};
@@ -53,6 +53,56 @@
 #include "ArduinoJson.h"
 
 #include <vector>
+#include <atomic>
+
+//hooks called by the loop scheduler (see SysModules), only those a module overrides
+enum LoopHooks { h_loop, h_loop20ms, h_loop1s, h_loop10s, h_dataSizeManager };
+
+#ifdef STARBASE_LOOP_PROFILE
+//histogram of LoopProfile: 4 buckets per power of 2 (the bound of a bucket is at most 25% above its values)
+#define PROFILE_MIN_POWER 8 //from 2^8 cycles (1 µs at 240 MHz), less in the first bucket
+#define PROFILE_POWERS 16 //to 2^24 cycles (70 ms at 240 MHz), more in the last bucket
+#define PROFILE_BUCKETS (PROFILE_POWERS * 4 + 2)
+
+//cycles spent in a loop hook of a module (see SysModules), reset each 10s
+struct LoopProfile {
+  unsigned32 count = 0;
+  uint64_t totalCycles = 0;
+  unsigned32 maxCycles = 0;
+  unsigned32 histogram[PROFILE_BUCKETS] = {}; //calls per bucket of cycles
+
+  static unsigned8 bucket(unsigned32 cycles) {
+    if (cycles < (1u << PROFILE_MIN_POWER)) return 0;
+    unsigned8 power = 31 - __builtin_clz(cycles);
+    if (power >= PROFILE_MIN_POWER + PROFILE_POWERS) return PROFILE_BUCKETS - 1;
+    return 1 + (power - PROFILE_MIN_POWER) * 4 + ((cycles >> (power - 2)) & 3); //quarter: 2 bits below the highest bit
+  }
+  //first cycles above bucket (not for the last bucket)
+  static unsigned32 bucketEnd(unsigned8 bucket) {
+    if (bucket == 0) return 1u << PROFILE_MIN_POWER;
+    unsigned8 power = PROFILE_MIN_POWER + (bucket - 1) / 4;
+    return (1u << power) + ((bucket - 1) % 4 + 1) * (1u << (power - 2));
+  }
+
+  void add(unsigned32 cycles) {
+    count++;
+    totalCycles += cycles;
+    if (cycles > maxCycles) maxCycles = cycles;
+    histogram[bucket(cycles)]++;
+  }
+  unsigned32 avg() {return count?totalCycles / count:0;}
+  //upper bound of the bucket of the 99th percentile (max if in the last bucket)
+  unsigned32 p99() {
+    unsigned32 below = 0;
+    for (forUnsigned8 bucket = 0; bucket < PROFILE_BUCKETS - 1; bucket++) {
+      below += histogram[bucket];
+      if ((uint64_t)below * 100 >= (uint64_t)count * 99) return min(bucketEnd(bucket) - 1, maxCycles);
+    }
+    return maxCycles;
+  }
+  void reset() {*this = LoopProfile();}
+};
+#endif
 
 class SysModule {
 
@@ -60,9 +110,19 @@ public:
   const char * name;
   bool success;
   bool isEnabled;
-  unsigned long twentyMsMillis = millis() - random(1000); //random so not all 1s are fired at once
+  unsigned long twentyMsMillis = millis() - random(1000); //random so not all 1s are fired at once (first due time)
   unsigned long oneSecondMillis = millis() - random(1000); //random so not all 1s are fired at once
   unsigned long tenSecondMillis = millis() - random(10000); //random within a second
+  bool loopIdle = false; //loop() does not need continuous calls: the main loop may sleep until a hook is due or mdls->wake()
+  //execution context of the loop hooks: UINT8_MAX: the main loop, else the core of a task of its own (see runInTask)
+  unsigned8 taskCore = UINT8_MAX;
+  unsigned8 taskPriority = 1;
+  unsigned16 taskStack = 4096;
+  TaskHandle_t taskHandle = nullptr; //created after setup of all modules
+  #ifdef STARBASE_LOOP_PROFILE
+    LoopProfile profiles[h_dataSizeManager]; //per LoopHooks hook, h_loop10s includes dataSizeManager
+    std::atomic<bool> profileReset{false}; //runInTask: set by the main loop, the profiles are reset by the task which writes them
+  #endif
 
   JsonObject parentVar;
 
@@ -72,9 +132,19 @@ public:
     isEnabled = true;
   }
 
+  //call in the constructor: loop hooks run in a task of its own, not delayed by other modules (setup and var functions still in the main loop)
+  //  the hooks run without modelMutex: change the model only via mdls->runInLoop
+  void runInTask(unsigned8 core, unsigned8 priority = 1, unsigned16 stack = 4096) {
+    taskCore = core;
+    taskPriority = priority;
+    taskStack = stack;
+  }
+
   virtual void setup() {}
 
-  virtual void loop() {}//24000 fps if no load...
+  //each pass of the main loop. The main loop sleeps until the next periodic hook is due if all loop() modules set loopIdle,
+  //  without loopIdle it runs continuously. mdls->wake() ends the sleep, e.g. when another task queued work for loop()
+  virtual void loop() {}
   virtual void loop20ms() {} //50fps
   virtual void loop1s() {} //1fps
   virtual void loop10s() {}
@@ -15,6 +15,29 @@
 #include "Sys/SysModWeb.h"
 #include "Sys/SysModModel.h"
 
+const char * LoopScheduler::hookNames[h_dataSizeManager] = {"loop", "loop20ms", "loop1s", "loop10s"};
+constexpr unsigned16 LoopScheduler::intervalPercent[7];
+
+//mdlTbl columns
+static VarColumn<String> mdlNameColumn;
+static VarColumn<bool> mdlSuccessColumn;
+static VarColumn<bool> mdlEnabledColumn;
+static VarColumn<size_t> mdlDataColumn;
+#ifdef STARBASE_LOOP_PROFILE
+static VarColumn<String> mdlProfileColumns[h_dataSizeManager];
+#endif
+
+#ifdef STARBASE_DEVMODE
+//module with the hooks of a typical module, see loopBenchmark
+class BenchModule: public SysModule {
+public:
+  unsigned32 calls = 0;
+  BenchModule(): SysModule("Bench") {}
+  void loop20ms() override {calls++;}
+  void loop1s() override {calls++;}
+};
+#endif
+
 SysModules::SysModules() {
 };
 
@@ -23,6 +46,21 @@ void SysModules::setup() {
     module->setup();
   }
 
+  for (SysModule *module:taskModules) {
+    LoopScheduler * taskScheduler = new LoopScheduler(); //created before the task: taskSchedulers does not change while tasks run
+    taskSchedulers.push_back(taskScheduler);
+    taskScheduler->add(module);
+  }
+  for (SysModule *module:taskModules) {
+    //core 0 on single core MCUs
+    if (xTaskCreatePinnedToCore(moduleTask, module->name, module->taskStack, module, module->taskPriority, &module->taskHandle, min<unsigned>(module->taskCore, portNUM_PROCESSORS - 1)) == pdPASS)
+      ppf("%s task created on core %d (prio %d, stack %d)\n", module->name, min<unsigned>(module->taskCore, portNUM_PROCESSORS - 1), module->taskPriority, module->taskStack);
+    else {
+      ppf("%s task not created, runs in the main loop\n", module->name);
+      scheduler.add(module);
+    }
+  }
+
   //delete mdlTbl values if nr of modules has changed (new values created using module defaults)
   for (JsonObject childVar: mdl->varChildren("mdlTbl")) {
     if (!childVar["value"].isNull() && mdl->varValArray(childVar).size() != modules.size()) {
@@ -44,8 +82,11 @@ void SysModules::setup() {
 
   ui->initText(tableVar, "mdlName", nullptr, 32, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
+      mdlNameColumn.attach(var);
       for (forUnsigned8 rowNr = 0; rowNr < modules.size(); rowNr++)
-        mdl->setValue(var, JsonString(modules[rowNr]->name, JsonString::Copied), rowNr);
+        mdlNameColumn.set(rowNr, modules[rowNr]->name);
+      mdlNameColumn.resize(modules.size());
+      mdlNameColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Name");
@@ -56,8 +97,11 @@ void SysModules::setup() {
   //UINT16_MAX: no value set
   ui->initCheckBox(tableVar, "mdlSuccess", UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
     case onSetValue:
+      mdlSuccessColumn.attach(var);
       for (forUnsigned8 rowNr = 0; rowNr < modules.size(); rowNr++)
-        mdl->setValue(var, modules[rowNr]->success, rowNr);
+        mdlSuccessColumn.set(rowNr, modules[rowNr]->success);
+      mdlSuccessColumn.resize(modules.size());
+      mdlSuccessColumn.commit();
       return true;
     case onUI:
       ui->setLabel(var, "Success");
@@ -69,8 +113,11 @@ void SysModules::setup() {
     case onSetValue:
       //never a rowNr as parameter, set all
       //execute only if var has not been set
+      mdlEnabledColumn.attach(var);
       for (forUnsigned8 rowNr = 0; rowNr < modules.size(); rowNr++)
-        mdl->setValue(var, modules[rowNr]->isEnabled, rowNr);
+        mdlEnabledColumn.set(rowNr, modules[rowNr]->isEnabled);
+      mdlEnabledColumn.resize(modules.size());
+      mdlEnabledColumn.commit();
       return true;
     case onUI:
       //initially set to true, but as enabled are table cells, will be updated to an array
@@ -88,46 +135,184 @@ void SysModules::setup() {
       return true;
     default: return false;
   }});
+
+  ui->initNumber(tableVar, "mdlData", UINT16_MAX, 0, (unsigned long)-1, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onSetValue:
+      mdlDataColumn.attach(var);
+      for (forUnsigned8 rowNr = 0; rowNr < modules.size(); rowNr++)
+        mdlDataColumn.set(rowNr, mdl->varMemoryEstimate(mdl->findVar(modules[rowNr]->name)));
+      mdlDataColumn.resize(modules.size());
+      mdlDataColumn.commit();
+      return true;
+    case onUI:
+      ui->setLabel(var, "Model (B)");
+      ui->setComment(var, "Estimated bytes of the vars of the module");
+      return true;
+    default: return false;
+  }});
+
+  #ifdef STARBASE_LOOP_PROFILE
+  for (forUnsigned8 hook = h_loop; hook < h_dataSizeManager; hook++) {
+    char id[16];
+    snprintf(id, sizeof(id), "mdlP%s", LoopScheduler::hookNames[hook]); //e.g. mdlPloop20ms
+    ui->initText(tableVar, id, nullptr, 32, true, [this, hook](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+      case onSetValue:
+        mdlProfileColumns[hook].attach(var);
+        for (forUnsigned8 rowNrL = (rowNr == UINT8_MAX)?0:rowNr; rowNrL < modules.size() && (rowNr == UINT8_MAX || rowNrL == rowNr); rowNrL++) {
+          LoopProfile &profile = modules[rowNrL]->profiles[hook];
+          char text[32] = "";
+          if (profile.count)
+            snprintf(text, sizeof(text), "%u / %u / %u #%u", profile.avg() / profileCyclesPerUs(), profile.p99() / profileCyclesPerUs(), profile.maxCycles / profileCyclesPerUs(), profile.count);
+          mdlProfileColumns[hook].set(rowNrL, text);
+        }
+        mdlProfileColumns[hook].commit();
+        return true;
+      case onUI:
+        ui->setLabel(var, LoopScheduler::hookNames[hook]);
+        ui->setComment(var, "avg / p99 / max µs #calls in 10s");
+        return true;
+      default: return false;
+    }});
+  }
+  #endif
+
+  #ifdef STARBASE_DEVMODE
+  ui->initButton(parentVar, "loopBenchmark", false, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    case onUI:
+      ui->setComment(var, "10s of loops each ms: scheduler vs polling all hooks");
+      return true;
+    case onChange: {
+      char result[128] = "";
+      for (unsigned16 nrOfModules: {20, 100}) {
+        std::vector<BenchModule> benchModules(nrOfModules);
+
+        LoopScheduler benchScheduler;
+        for (BenchModule &module: benchModules) benchScheduler.add(&module);
+        unsigned long now = millis();
+        unsigned long start = micros();
+        for (int i = 0; i < 10000; i++)
+          benchScheduler.loop(now++);
+        unsigned long schedulerTime = micros() - start;
+
+        //as before the scheduler: check all hooks of all modules each loop
+        now = millis();
+        start = micros();
+        for (int i = 0; i < 10000; i++, now++) {
+          for (BenchModule &module: benchModules) {
+            module.loop();
+            if (now - module.twentyMsMillis >= 20) {module.twentyMsMillis = now; module.loop20ms();}
+            if (now - module.oneSecondMillis >= 1000) {module.oneSecondMillis = now; module.loop1s();}
+            if (now - module.tenSecondMillis >= 10000) {module.tenSecondMillis = now; module.loop10s(); module.dataSizeManager();}
+          }
+        }
+        unsigned long pollTime = micros() - start;
+
+        ppf("dev loopBenchmark %d modules: scheduler %.2f µs/loop, polling %.2f µs/loop\n", nrOfModules, schedulerTime / 10000.0, pollTime / 10000.0);
+        snprintf(result + strlen(result), sizeof(result) - strlen(result), "%d modules: %.2f vs %.2f µs/loop ", nrOfModules, schedulerTime / 10000.0, pollTime / 10000.0);
+      }
+      web->addResponseV(var["id"], "comment", "%s", result);
+      return true; }
+    default: return false;
+  }});
+  #endif
 }
 
 void SysModules::loop() {
-  // bool oneSec = false;
-  // bool tenSec = false;
-  // if (millis() - oneSecondMillis >= 1000) {
-  //   oneSecondMillis = millis();
-  //   oneSec = true;
-  // }
-  // if (millis() - tenSecondMillis >= 10000) {
-  //   tenSecondMillis = millis();
-  //   tenSec = true;
-  // }
-  for (SysModule *module:modules) {
-    if (module->isEnabled && module->success) {
-      module->loop();
-      if (millis() - module->twentyMsMillis >= 20) {
-        module->twentyMsMillis = millis();
-        module->loop20ms();
-      }
-      if (millis() - module->oneSecondMillis >= 1000) {
-        module->oneSecondMillis = millis();
-        module->loop1s();
+  xSemaphoreTake(mdl->modelMutex, portMAX_DELAY); //other tasks can read the model between loops (e.g. /json/mdl)
+  if (handoffPending) {
+    xSemaphoreTake(handoffMutex, portMAX_DELAY);
+    runningHandoffs.swap(handoffs);
+    handoffPending = false;
+    xSemaphoreGive(handoffMutex);
+    for (std::function<void()> &fun: runningHandoffs) fun();
+    runningHandoffs.clear(); //capacity kept for the next swap
+  }
+  scheduler.loop(millis());
+  xSemaphoreGive(mdl->modelMutex);
+  if (millis() - tenSecondMillis >= 10000) {
+    tenSecondMillis = millis();
+    if (web->ws.count()) {
+      xSemaphoreTake(mdl->modelMutex, portMAX_DELAY); //estimate walks the model
+      ui->callVarFun("mdlData", UINT8_MAX, onSetValue);
+      xSemaphoreGive(mdl->modelMutex);
+    }
+    #ifdef STARBASE_LOOP_PROFILE
+      xSemaphoreTake(mdl->modelMutex, portMAX_DELAY); //not while /json/profile reads them
+      if (web->ws.count()) {
+        for (forUnsigned8 hook = h_loop; hook < h_dataSizeManager; hook++) {
+          char id[16];
+          snprintf(id, sizeof(id), "mdlP%s", LoopScheduler::hookNames[hook]);
+          ui->callVarFun(id, UINT8_MAX, onSetValue);
+        }
       }
-      if (millis() - module->tenSecondMillis >= 10000) {
-        module->tenSecondMillis = millis();
-        module->loop10s();
+      for (SysModule *module:modules) {
+        if (module->taskHandle)
+          module->profileReset = true; //written by its task, see moduleTask
+        else
+          for (LoopProfile &profile: module->profiles) profile.reset();
       }
-      // module->testManager();
-      // module->performanceManager();
-      // module->dataSizeManager();
-      // module->codeSizeManager();
-    }
+      profileMillis = millis();
+      xSemaphoreGive(mdl->modelMutex);
+    #endif
   }
+
   if (newConnection) {
     newConnection = false;
     isConnected = true;
     connectedChanged();
   }
 
+  //sleep until the next hook is due or wake() (the notification of a wake() while running is not lost)
+  unsigned long idle = scheduler.idleMillis(millis());
+  if (idle) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idle));
+
+}
+
+#ifdef STARBASE_LOOP_PROFILE
+void SysModules::profileToJson(JsonObject root) {
+  root["cpuMHz"] = profileCyclesPerUs();
+  root["ms"] = millis() - profileMillis;
+  JsonObject modulesObject = root["modules"].to<JsonObject>();
+  for (SysModule *module:modules) {
+    JsonObject moduleObject = modulesObject[module->name].to<JsonObject>();
+    for (forUnsigned8 hook = h_loop; hook < h_dataSizeManager; hook++) {
+      LoopProfile &profile = module->profiles[hook];
+      if (!profile.count) continue; //not called (not overridden or disabled)
+      JsonObject hookObject = moduleObject[LoopScheduler::hookNames[hook]].to<JsonObject>();
+      hookObject["count"] = profile.count;
+      hookObject["avg"] = (float)profile.avg() / profileCyclesPerUs();
+      hookObject["p99"] = (float)profile.p99() / profileCyclesPerUs();
+      hookObject["max"] = (float)profile.maxCycles / profileCyclesPerUs();
+    }
+  }
+}
+#endif
+
+LoopScheduler::HookTiming SysModules::hookTiming(unsigned8 hook) {
+  LoopScheduler::HookTiming total = scheduler.timings[hook - h_loop20ms];
+  for (LoopScheduler *taskScheduler: taskSchedulers) {
+    LoopScheduler::HookTiming &timing = taskScheduler->timings[hook - h_loop20ms];
+    for (forUnsigned8 bucket = 0; bucket < 8; bucket++) total.histogram[bucket] += timing.histogram[bucket];
+    total.missed += timing.missed;
+  }
+  return total;
+}
+
+LoopScheduler * SysModules::lastOverrun(unsigned32 &overruns) {
+  LoopScheduler * last = scheduler.overrunModule?&scheduler:nullptr;
+  overruns = scheduler.overruns;
+  for (LoopScheduler *taskScheduler: taskSchedulers) {
+    overruns += taskScheduler->overruns;
+    if (taskScheduler->overrunModule && (!last || (long)(taskScheduler->overrunMillis - last->overrunMillis) > 0))
+      last = taskScheduler;
+  }
+  return last;
+}
+
+void SysModules::resetTiming() {
+  scheduler.resetTiming();
+  for (LoopScheduler *taskScheduler: taskSchedulers)
+    taskScheduler->timingReset = true; //by its task
 }
 
 void SysModules::reboot() {
@@ -138,10 +323,157 @@ void SysModules::reboot() {
 
 void SysModules::add(SysModule* module) {
   modules.push_back(module);
+  if (module->taskCore == UINT8_MAX)
+    scheduler.add(module);
+  else
+    taskModules.push_back(module); //task created in setup
+}
+
+void SysModules::runInLoop(std::function<void()> fun) {
+  if (xTaskGetCurrentTaskHandle() == print->loopTaskHandle)
+    fun(); //main loop: modelMutex taken already
+  else {
+    xSemaphoreTake(handoffMutex, portMAX_DELAY);
+    handoffs.push_back(fun);
+    handoffPending = true;
+    xSemaphoreGive(handoffMutex);
+    wake();
+  }
+}
+
+void SysModules::wake() {
+  if (print->loopTaskHandle) xTaskNotifyGive(print->loopTaskHandle);
+}
+
+void SysModules::moduleTask(void * parameter) {
+  SysModule * module = (SysModule *)parameter;
+  LoopScheduler &moduleScheduler = *mdls->taskSchedulers[std::find(mdls->taskModules.begin(), mdls->taskModules.end(), module) - mdls->taskModules.begin()];
+  for (;;) {
+    #ifdef STARBASE_LOOP_PROFILE
+      if (module->profileReset) {
+        for (LoopProfile &profile: module->profiles) profile.reset();
+        module->profileReset = false;
+      }
+    #endif
+    moduleScheduler.loop(millis());
+    web->sendResponseObject(); //ppf and addResponse of this task (own responseDoc)
+    vTaskDelay(max<TickType_t>(pdMS_TO_TICKS(moduleScheduler.idleMillis(millis())), 1)); //at least 1 tick: let lower priority tasks run
+  }
 }
 
 void SysModules::connectedChanged() {
   for (SysModule *module:modules) {
     module->connectedChanged();
   }
-}
\ No newline at end of file
+}
+//the function a virtual hook of module resolves to (GCC extension: function pointer of a bound member function)
+typedef void (SysModule::*HookFunction)();
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpmf-conversions"
+static void * hookAddress(SysModule * module, HookFunction hook) {return (void *)(module->*hook);}
+#pragma GCC diagnostic pop
+
+//LoopHooks bits of the hooks module overrides: the hook is another function than the one of SysModule
+//  (an override calling the SysModule hook is still an override)
+static unsigned8 overriddenHooks(SysModule * module) {
+  static SysModule base("base"); //created on first use, not before setup (the constructor uses millis and random)
+  static const HookFunction hooks[] = {&SysModule::loop, &SysModule::loop20ms, &SysModule::loop1s, &SysModule::loop10s, &SysModule::dataSizeManager}; //LoopHooks order
+  unsigned8 overridden = 0;
+  for (forUnsigned8 hook = h_loop; hook <= h_dataSizeManager; hook++)
+    if (hookAddress(module, hooks[hook]) != hookAddress(&base, hooks[hook])) overridden |= 1 << hook;
+  return overridden;
+}
+
+void LoopScheduler::add(SysModule * module) {
+  unsigned8 overridden = overriddenHooks(module);
+  if (overridden & (1 << h_loop))
+    loopModules.push_back(module);
+  if (overridden & (1 << h_loop20ms)) {
+    heap.push_back({module->twentyMsMillis + 20, module, h_loop20ms, 0});
+    std::push_heap(heap.begin(), heap.end(), later);
+  }
+  if (overridden & (1 << h_loop1s)) {
+    heap.push_back({module->oneSecondMillis + 1000, module, h_loop1s, 0});
+    std::push_heap(heap.begin(), heap.end(), later);
+  }
+  if (overridden & ((1 << h_loop10s) | (1 << h_dataSizeManager))) {
+    heap.push_back({module->tenSecondMillis + 10000, module, h_loop10s, 0});
+    std::push_heap(heap.begin(), heap.end(), later);
+  }
+}
+
+unsigned long LoopScheduler::idleMillis(unsigned long now) {
+  for (SysModule *module: loopModules)
+    if (!module->loopIdle && module->isEnabled && module->success) return 0;
+  if (heap.empty()) return 1000; //nothing scheduled: check once a second (no periodic hooks overridden)
+  long due = heap.front().due - now;
+  return due > 0?due:0;
+}
+
+void LoopScheduler::resetTiming() {
+  for (HookTiming &timing: timings) timing = HookTiming();
+  overruns = 0;
+  overrunModule = nullptr;
+  overrunMicros = 0;
+  overrunMillis = 0;
+}
+
+void LoopScheduler::timeCall(SysModule * module, unsigned8 hook, unsigned long callMicros) {
+  if (callMicros > 20000) {
+    overruns++;
+    overrunModule = module->name;
+    overrunHook = hook;
+    overrunMicros = callMicros;
+    overrunMillis = millis();
+  }
+}
+
+void LoopScheduler::loop(unsigned long now) {
+  if (timingReset) { //requested by SysModules::resetTiming, done here as this task writes the timings
+    resetTiming();
+    timingReset = false;
+  }
+
+  for (SysModule *module: loopModules) {
+    if (module->isEnabled && module->success) {
+      unsigned long startMicros = micros();
+      PROFILE_HOOK(module, h_loop, module->loop());
+      timeCall(module, h_loop, micros() - startMicros);
+    }
+  }
+
+  while (!heap.empty() && (long)(now - heap.front().due) >= 0) {
+    std::pop_heap(heap.begin(), heap.end(), later);
+    LoopDue &loopDue = heap.back();
+    SysModule * module = loopDue.module;
+    unsigned long interval;
+    unsigned long startMicros = micros(); //not now: later if hooks before took long
+    switch (loopDue.hook) {
+      case h_loop20ms:
+        if (module->isEnabled && module->success) PROFILE_HOOK(module, h_loop20ms, module->loop20ms());
+        interval = 20;
+        break;
+      case h_loop1s:
+        if (module->isEnabled && module->success) PROFILE_HOOK(module, h_loop1s, module->loop1s());
+        interval = 1000;
+        break;
+      default:
+        if (module->isEnabled && module->success) PROFILE_HOOK(module, h_loop10s, module->loop10s(); module->dataSizeManager());
+        interval = 10000;
+    }
+    if (module->isEnabled && module->success) {
+      timeCall(module, loopDue.hook, micros() - startMicros);
+      if (loopDue.lastMicros) {
+        HookTiming &timing = timings[loopDue.hook - h_loop20ms];
+        uint64_t elapsed = startMicros - loopDue.lastMicros; //micros wrap safe, 64 bits: * 100 does not overflow
+        unsigned8 bucket = 0;
+        while (bucket < 7 && elapsed * 100 > interval * 1000ULL * intervalPercent[bucket]) bucket++;
+        timing.histogram[bucket]++;
+        if (elapsed >= interval * 2000ULL) timing.missed++;
+      }
+    }
+    loopDue.lastMicros = startMicros | 1; //never 0 (not called yet), 1 µs off at most
+    loopDue.due = now + interval;
+    std::push_heap(heap.begin(), heap.end(), later);
+  }
+}
@@ -12,6 +12,65 @@
 #pragma once
 #include "SysModule.h"
 
+#include <algorithm>
+
+#ifdef STARBASE_LOOP_PROFILE
+  #ifdef ARDUINO
+    #define profileCycles() ESP.getCycleCount()
+    #define profileCyclesPerUs() ESP.getCpuFreqMHz()
+  #else //host: nanoseconds as cycles
+    #include <chrono>
+    #define profileCycles() (unsigned32)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()
+    #define profileCyclesPerUs() 1000
+  #endif
+  //time the call of a hook of a module
+  #define PROFILE_HOOK(module, hook, call) {unsigned32 startCycles = profileCycles(); call; module->profiles[hook].add(profileCycles() - startCycles);}
+#else
+  #define PROFILE_HOOK(module, hook, call) {call;}
+#endif
+
+//calls the loop hooks of modules: loop() each time, the periodic hooks from a min-heap on due time so only what is due
+//  is checked. Only the hooks a module overrides are scheduled (see add)
+class LoopScheduler {
+public:
+  void add(SysModule * module);
+  void loop(unsigned long now);
+  //ms until a hook is due, 0 if there are loop() modules without loopIdle
+  unsigned long idleMillis(unsigned long now);
+
+  static const char * hookNames[h_dataSizeManager]; //LoopHooks without dataSizeManager
+
+  //intervals between calls of a periodic hook (over all modules) in % of the hook interval
+  struct HookTiming {
+    unsigned32 histogram[8] = {}; //calls per bucket of intervalPercent, last: more
+    unsigned32 missed = 0; //called a whole interval or more after due: a frame skipped
+  };
+  static constexpr unsigned16 intervalPercent[7] = {105, 110, 125, 150, 200, 300, 500}; //upper bounds of the buckets
+  HookTiming timings[3]; //h_loop20ms, h_loop1s, h_loop10s
+  //a hook call longer than the loop20ms interval delays the other modules: last one
+  unsigned32 overruns = 0;
+  const char * overrunModule = nullptr;
+  unsigned8 overrunHook = h_loop;
+  unsigned long overrunMicros = 0;
+  unsigned long overrunMillis = 0; //when the last overrun happened
+
+  void resetTiming(); //in the task running this scheduler, else set timingReset
+  std::atomic<bool> timingReset{false}; //resetTiming at the next loop
+
+private:
+  struct LoopDue {
+    unsigned long due;
+    SysModule * module;
+    unsigned8 hook; //h_loop20ms, h_loop1s or h_loop10s (+ dataSizeManager)
+    unsigned long lastMicros; //start of the last call, 0: not called yet
+  };
+  std::vector<SysModule *> loopModules; //modules overriding loop()
+  std::vector<LoopDue> heap; //earliest due first
+
+  static bool later(const LoopDue &a, const LoopDue &b) {return (long)(a.due - b.due) > 0;} //millis wrap safe
+  void timeCall(SysModule * module, unsigned8 hook, unsigned long callMicros);
+};
+
 class SysModules {
 public:
   bool newConnection = false;
@@ -29,10 +88,43 @@ public:
 
   void connectedChanged();
 
+  //the main loop sleeps until the next hook is due: call to let it run now, e.g. after queueing work for it from another task
+  void wake();
+
+  //run fun in the main loop under modelMutex, e.g. model changes of a module running in its own task (directly if called in the main loop)
+  void runInLoop(std::function<void()> fun);
+
+  std::vector<SysModule *> taskModules; //modules running in a task of their own (runInTask)
+  LoopScheduler scheduler; //of the main loop
+  std::vector<LoopScheduler *> taskSchedulers; //of taskModules (same index), created in setup
+
+  //interval timings of a periodic hook over all schedulers: main loop and module tasks
+  //  the task schedulers are read while their tasks run: values may be one call behind
+  LoopScheduler::HookTiming hookTiming(unsigned8 hook);
+  //scheduler with the latest overrun (nullptr if none), overruns: over all schedulers
+  LoopScheduler * lastOverrun(unsigned32 &overruns);
+  //in the main loop (see runInLoop): resets the main loop scheduler, the module tasks reset their own
+  void resetTiming();
+
+  #ifdef STARBASE_LOOP_PROFILE
+    //{"cpuMHz":240, "ms":window, "modules":{"name":{"loop20ms":{"count":n, "avg":µs, "p99":µs, "max":µs}}}} (/json/profile)
+    void profileToJson(JsonObject root);
+  #endif
+
 private:
   std::vector<SysModule *> modules;
+  #ifdef STARBASE_LOOP_PROFILE
+    unsigned long profileMillis = millis(); //start of the profile window
+  #endif
+  SemaphoreHandle_t handoffMutex = xSemaphoreCreateMutex();
+  std::vector<std::function<void()>> handoffs; //runInLoop from other tasks, under handoffMutex
+  std::vector<std::function<void()>> runningHandoffs; //swapped with handoffs: both keep their capacity, no allocation per handoff
+  std::atomic<bool> handoffPending{false}; //handoffs not empty, checked each loop without handoffMutex
+
+  //loop hooks of a module with runInTask
+  static void moduleTask(void * parameter);
   // unsigned long oneSecondMillis = 0;
-  // unsigned long tenSecondMillis = millis() - 4500;
+  unsigned long tenSecondMillis = millis() - 4500;
 };
 
 extern SysModules *mdls;
\ No newline at end of file
@@ -20,6 +20,7 @@ public:
 
   UserModE131() :SysModule("E131") {
     isEnabled = false; //default not enabled
+    runInTask(0, 2); //packets handled also if the main loop is busy (e.g. listing files)
   };
 
   void setup() {
@@ -56,8 +57,11 @@ public:
 
     ui->initNumber(tableVar, "e131Channel", UINT16_MAX, 1, 512, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
+        e131ChannelColumn.attach(var);
         for (forUnsigned8 rowNr = 0; rowNr < varsToWatch.size(); rowNr++)
-          mdl->setValue(var, channel + varsToWatch[rowNr].channelOffset, rowNr);
+          e131ChannelColumn.set(rowNr, channel + varsToWatch[rowNr].channelOffset);
+        e131ChannelColumn.resize(varsToWatch.size());
+        e131ChannelColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Channel");
@@ -67,8 +71,11 @@ public:
 
     ui->initText(tableVar, "e131Name", nullptr, 32, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
+        e131NameColumn.attach(var);
         for (forUnsigned8 rowNr = 0; rowNr < varsToWatch.size(); rowNr++)
-          mdl->setValue(var, varsToWatch[rowNr].id, rowNr);
+          e131NameColumn.set(rowNr, varsToWatch[rowNr].id);
+        e131NameColumn.resize(varsToWatch.size());
+        e131NameColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Name");
@@ -78,8 +85,11 @@ public:
 
     ui->initNumber(tableVar, "e131Max", UINT16_MAX, 0, UINT16_MAX, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
+        e131MaxColumn.attach(var);
         for (forUnsigned8 rowNr = 0; rowNr < varsToWatch.size(); rowNr++)
-          mdl->setValue(var, varsToWatch[rowNr].max, rowNr);
+          e131MaxColumn.set(rowNr, varsToWatch[rowNr].max);
+        e131MaxColumn.resize(varsToWatch.size());
+        e131MaxColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Max");
@@ -89,8 +99,11 @@ public:
 
     ui->initNumber(tableVar, "e131Value", UINT16_MAX, 0, 255, true, [this](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onSetValue:
+        e131ValueColumn.attach(var);
         for (forUnsigned8 rowNr = 0; rowNr < varsToWatch.size(); rowNr++)
-          mdl->setValue(var, varsToWatch[rowNr].savedValue, rowNr);
+          e131ValueColumn.set(rowNr, varsToWatch[rowNr].savedValue);
+        e131ValueColumn.resize(varsToWatch.size());
+        e131ValueColumn.commit();
         return true;
       case onUI:
         ui->setLabel(var, "Value");
@@ -109,33 +122,28 @@ public:
   // }
 
   void onOffChanged() {
-
-    if (mdls->isConnected && isEnabled) {
-      ppf("UserModE131::connected && enabled\n");
-
-      if (e131Created) { // TODO: crashes here - no idea why!
-        ppf("UserModE131 - ESPAsyncE131 created already\n");
-        return;
-      }
-      ppf("UserModE131 - Create ESPAsyncE131\n");
-
-      e131 = ESPAsyncE131(universeCount);
-      if (this->e131.begin(E131_MULTICAST, universe, universeCount)) { // TODO: multicast igmp failing, so only works with unicast currently
-        ppf("Network exists, begin e131.begin ok\n");
-        success = true;
-      }
-      else {
-        ppf("Network exists, begin e131.begin FAILED\n");
-      }
-      e131Created = true;
-    }
-    else {
-      // e131.end();//???
-      e131Created = false;
-    }
+    //e131 is created and read in the task of this module (see loop20ms)
+    e131Wanted = mdls->isConnected && isEnabled;
+    ppf("UserModE131::onOffChanged connected && enabled: %d\n", e131Wanted.load());
   }
 
   void loop20ms() {
+    if (e131Wanted != e131Created) {
+      if (e131Wanted) {
+        ppf("UserModE131 - Create ESPAsyncE131\n");
+
+        e131 = ESPAsyncE131(universeCount);
+        if (this->e131.begin(E131_MULTICAST, universe, universeCount)) { // TODO: multicast igmp failing, so only works with unicast currently
+          ppf("Network exists, begin e131.begin ok\n");
+          success = true;
+        }
+        else {
+          ppf("Network exists, begin e131.begin FAILED\n");
+        }
+      }
+      // else e131.end();//???
+      e131Created = e131Wanted;
+    }
     if(!e131Created) {
       return;
     }
@@ -143,6 +151,8 @@ public:
       e131_packet_t packet;
       e131.pull(&packet);     // Pull packet from ring buffer
 
+      bool changed = false;
+
       for (VarToWatch &varToWatch : varsToWatch) {
         for (int i=0; i < maxChannels; i++) {
           if (i == channel + varToWatch.channelOffset) {
@@ -161,7 +171,10 @@ public:
 
               if (varToWatch.id != nullptr && varToWatch.max != 0) {
                 ppf(" varsToWatch: %s\n", varToWatch.id);
-                mdl->setValue(varToWatch.id, varToWatch.savedValue%(varToWatch.max+1)); // TODO: ugly to have magic string 
+                xSemaphoreTake(pendingMutex, portMAX_DELAY);
+                varToWatch.pendingValue = varToWatch.savedValue%(varToWatch.max+1); //latest value, set in the main loop
+                xSemaphoreGive(pendingMutex);
+                changed = true;
               }
               else
                 ppf("\n");
@@ -169,6 +182,21 @@ public:
           }//if channel
         }//maxChannels
       } //for varToWatch
+      if (changed && !handoffQueued.exchange(true)) { //one handoff queued at most, it sets the latest values
+        mdls->runInLoop([this]() {
+          handoffQueued = false; //values pending after this are set by the next handoff
+          mdl->beginBatch(); //onChange of all changed channels after the frame is processed
+          xSemaphoreTake(pendingMutex, portMAX_DELAY);
+          for (VarToWatch &varToWatch: varsToWatch) {
+            if (varToWatch.pendingValue != -1) {
+              mdl->setValue(varToWatch.id, (unsigned8)varToWatch.pendingValue);
+              varToWatch.pendingValue = -1;
+            }
+          }
+          xSemaphoreGive(pendingMutex);
+          mdl->commitBatch();
+        });
+      }
     } //!e131.isEmpty()
   } //loop
 
@@ -197,11 +225,20 @@ public:
       const char * id = nullptr;
       unsigned16 max = -1;
       unsigned8 savedValue = -1;
+      int16_t pendingValue = -1; //to set in the main loop, -1: none. Under pendingMutex
     };
 
     std::vector<VarToWatch> varsToWatch;
+    VarColumn<unsigned16> e131ChannelColumn;
+    VarColumn<String> e131NameColumn;
+    VarColumn<unsigned16> e131MaxColumn;
+    VarColumn<unsigned8> e131ValueColumn;
+
+    SemaphoreHandle_t pendingMutex = xSemaphoreCreateMutex();
+    std::atomic<bool> handoffQueued{false};
 
-    ESPAsyncE131 e131;
+    ESPAsyncE131 e131; //created, begun and read in the task of this module
+    std::atomic<bool> e131Wanted{false}; //connected and enabled, set by the main loop
     boolean e131Created = false;
     unsigned16 channel = 1;
     unsigned16 universe = 1;
@@ -112,8 +112,8 @@ public:
       default: return false; 
     }}); //script
 
-    ui->initText(parentVar, "fps1", nullptr, 10, true);
-    ui->initText(parentVar, "fps2", nullptr, 10, true);
+    fps1Var = ui->initText(parentVar, "fps1", nullptr, 10, true);
+    fps2Var = ui->initText(parentVar, "fps2", nullptr, 10, true);
 
     // ui->initButton
 
@@ -134,11 +134,15 @@ public:
   }
 
   void loop1s() {
-    mdl->setUIValueV("fps1", "%.0f /s", fps);
-    mdl->setUIValueV("fps2", "%d /s", frameCounter);
+    fps1Var.setUIValueV("%.0f /s", fps);
+    fps2Var.setUIValueV("%d /s", frameCounter);
     frameCounter = 0;
   }
 
+private:
+  VarHandle<> fps1Var;
+  VarHandle<> fps2Var;
+
 };
 
 extern UserModLive *liveM;
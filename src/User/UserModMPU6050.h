@@ -26,10 +26,13 @@ public:
 
   Coord3D gyro; // in degrees (not radians)
   Coord3D accell;
+  VarHandle<Coord3D> gyroVar;
+  VarHandle<Coord3D> accellVar;
   VectorFloat gravityVector;
 
   UserModMPU6050() :SysModule("Motion Tracking") {
     isEnabled = false; //need to enable after fresh setup
+    runInTask(0); //I2C reads do not delay the main loop
   };
 
   void setup() {
@@ -43,14 +46,14 @@ public:
       default: return false;
     }}); 
 
-    ui->initCoord3D(parentVar, "gyro", &gyro, 0, UINT16_MAX, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    gyroVar = ui->initCoord3D(parentVar, "gyro", &gyro, 0, UINT16_MAX, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onUI:
         ui->setComment(var, "in degrees");
         return true;
       default: return false;
     }});
 
-    ui->initCoord3D(parentVar, "accell", &accell, 0, UINT16_MAX, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
+    accellVar = ui->initCoord3D(parentVar, "accell", &accell, 0, UINT16_MAX, true, [](JsonObject var, unsigned8 rowNr, unsigned8 funType) { switch (funType) { //varFun
       case onUI:
         ui->setComment(var, "in m/s²");
         return true;
@@ -104,9 +107,12 @@ public:
       mpu.dmpGetQuaternion(&q, fifoBuffer);
       mpu.dmpGetGravity(&gravity, &q);
       mpu.dmpGetYawPitchRoll(ypr, &q, &gravity);
-      gyro.y = ypr[0] * 180/M_PI; //pan = yaw !
-      gyro.x = ypr[1] * 180/M_PI; //tilt = pitch !
-      gyro.z = ypr[2] * 180/M_PI; //roll = roll
+      //not in gyro and accell: these are set in the main loop (see loop1s)
+      xSemaphoreTake(latestMutex, portMAX_DELAY);
+      latestGyro.y = ypr[0] * 180/M_PI; //pan = yaw !
+      latestGyro.x = ypr[1] * 180/M_PI; //tilt = pitch !
+      latestGyro.z = ypr[2] * 180/M_PI; //roll = roll
+      xSemaphoreGive(latestMutex);
       gravityVector = gravity;
       // display real acceleration, adjusted to remove gravity
 
@@ -118,9 +124,11 @@ public:
       mpu.dmpGetLinearAccel(&aaReal, &aa, &gravity);
       // mpu.dmpGetLinearAccelInWorld(&aaWorld, &aaReal, &q); //worked in 0.6.0, not in 1.3.0 anymore
 
-      accell.x = aaReal.x;
-      accell.y = aaReal.y;
-      accell.z = aaReal.z;
+      xSemaphoreTake(latestMutex, portMAX_DELAY);
+      latestAccell.x = aaReal.x;
+      latestAccell.y = aaReal.y;
+      latestAccell.z = aaReal.z;
+      xSemaphoreGive(latestMutex);
     }
   }
 
@@ -128,13 +136,28 @@ public:
     //for debugging
     // ppf("mpu6050 ptr:%d,%d,%d ar:%d,%d,%d\n", gyro.x, gyro.y, gyro.z, accell.x, accell.y, accell.z);
 
-    mdl->setValue("gyro", gyro);
-    mdl->setValue("accell", accell);
+    if (!handoffQueued.exchange(true)) { //one handoff queued at most, it sets the latest values
+      mdls->runInLoop([this]() {
+        handoffQueued = false;
+        xSemaphoreTake(latestMutex, portMAX_DELAY);
+        Coord3D gyroNew = latestGyro;
+        Coord3D accellNew = latestAccell;
+        xSemaphoreGive(latestMutex);
+        gyroVar.set(gyroNew);
+        accellVar.set(accellNew);
+      });
+    }
   }
 
   private:
     MPU6050 mpu;
 
+    //read in the task of this module, set in gyro and accell by the main loop
+    SemaphoreHandle_t latestMutex = xSemaphoreCreateMutex();
+    Coord3D latestGyro = {0, 0, 0};
+    Coord3D latestAccell = {0, 0, 0};
+    std::atomic<bool> handoffQueued{false};
+
     // MPU control/status vars
     uint8_t devStatus;      // return status after each device operation (0 = success, !0 = error)
     uint8_t fifoBuffer[64]; // FIFO storage buffer
@@ -0,0 +1,108 @@
+/*
+   @title     StarBase
+   @file      test_findvar.cpp
+   @date      20240411
+   @repo      https://github.com/ewowi/StarBase, submit changes to this file as PRs to ewowi/StarBase
+   @Authors   https://github.com/ewowi/StarBase/commits/main
+   @Copyright © 2024 Github StarBase Commit Authors
+   @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+   @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+*/
+
+//host benchmark of findVar: VarIndex (see SysVarIndex.h) against walking the model, for growing models made of misc/model.json
+//  pio test -e native -v
+
+#include <unity.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SysVarIndex.h"
+
+static JsonDocument fixture; //misc/model.json
+
+//as findVar before the index: walk the model and compare ids
+static JsonObject walkVar(const char * id, JsonArray vars) {
+  for (JsonObject var : vars) {
+    if (var["id"] == id)
+      return var;
+    else if (!var["n"].isNull()) {
+      JsonObject foundVar = walkVar(id, var["n"]);
+      if (!foundVar.isNull())
+        return foundVar;
+    }
+  }
+  return JsonObject();
+}
+
+//copy of vars with "_<copyNr>" added to each id (copyNr 0: ids as is)
+static void copyVars(JsonArray source, JsonArray dest, unsigned copyNr) {
+  for (JsonObject var : source) {
+    JsonObject copy = dest.add<JsonObject>();
+    for (JsonPair pair : var) {
+      if (pair.key() == "n")
+        copyVars(pair.value(), copy["n"].to<JsonArray>(), copyNr);
+      else if (pair.key() == "id" && copyNr)
+        copy["id"] = std::string(pair.value().as<const char *>()) + "_" + std::to_string(copyNr);
+      else
+        copy[pair.key()] = pair.value();
+    }
+  }
+}
+
+static unsigned long microsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void test_fixture() {
+  std::ifstream file("misc/model.json");
+  std::stringstream text;
+  text << file.rdbuf();
+  TEST_ASSERT_FALSE_MESSAGE(deserializeJson(fixture, text.str()), "misc/model.json");
+  TEST_ASSERT_TRUE(fixture.is<JsonArray>());
+}
+
+//lookup of all ids, 1x to 16x the fixture: the index stays flat, the walk grows with the model
+void test_findvar_benchmark() {
+  for (unsigned copies: {1, 2, 4, 8, 16}) {
+    JsonDocument modelDoc;
+    JsonArray model = modelDoc.to<JsonArray>();
+    for (unsigned copyNr = 0; copyNr < copies; copyNr++)
+      copyVars(fixture.as<JsonArray>(), model, copyNr);
+
+    VarIndex varIndex;
+    varIndex.addAll(model);
+    std::vector<const char *> ids;
+    varIndex.ids(ids);
+    TEST_ASSERT_TRUE(ids.size() > 0);
+
+    auto start = std::chrono::steady_clock::now();
+    VarIndexEntry entry;
+    unsigned found = 0;
+    for (const char * id: ids) found += varIndex.find(id, entry);
+    unsigned long indexTime = microsSince(start);
+    TEST_ASSERT_EQUAL(ids.size(), found);
+
+    start = std::chrono::steady_clock::now();
+    for (const char * id: ids) TEST_ASSERT_FALSE(walkVar(id, model).isNull());
+    unsigned long walkTime = microsSince(start);
+
+    for (const char * id: ids) { //same var as the walk
+      varIndex.find(id, entry);
+      TEST_ASSERT_TRUE(entry.var == walkVar(id, model));
+    }
+
+    char message[128];
+    snprintf(message, sizeof(message), "%u vars: index %.3f µs/lookup, walk %.3f µs/lookup", (unsigned)ids.size(), (float)indexTime / ids.size(), (float)walkTime / ids.size());
+    TEST_MESSAGE(message);
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixture);
+  RUN_TEST(test_findvar_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,124 @@
+/*
+   @title     StarBase
+   @file      test_snapshot.cpp
+   @date      20240411
+   @repo      https://github.com/ewowi/StarBase, submit changes to this file as PRs to ewowi/StarBase
+   @Authors   https://github.com/ewowi/StarBase/commits/main
+   @Copyright © 2024 Github StarBase Commit Authors
+   @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+   @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+*/
+
+//host benchmark of reading the model at boot: misc/model.json parsed as JSON vs as MessagePack snapshot (see readModelSnapshot)
+//  time and heap peak of the model document, pio test -e native -v
+//  the snapshot is made by serializeMsgPack: same format as StarJson::writeMsgPackDocToFile, without its exclusions and header
+
+#include <unity.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "ArduinoJson.h"
+
+//counts the bytes of a document, as RAM_Allocator, and keeps the peak
+struct PeakAllocator: ArduinoJson::Allocator {
+  size_t bytes = 0;
+  size_t peak = 0;
+
+  void* allocate(size_t size) override {
+    size_t * block = (size_t *)malloc(size + sizeof(size_t));
+    if (!block) return nullptr;
+    *block = size;
+    count(size);
+    return block + 1;
+  }
+  void deallocate(void* pointer) override {
+    if (!pointer) return;
+    size_t * block = (size_t *)pointer - 1;
+    bytes -= *block;
+    free(block);
+  }
+  void* reallocate(void* pointer, size_t newSize) override {
+    if (!pointer) return allocate(newSize);
+    size_t * block = (size_t *)pointer - 1;
+    size_t oldSize = *block;
+    block = (size_t *)realloc(block, newSize + sizeof(size_t));
+    if (!block) return nullptr;
+    *block = newSize;
+    bytes -= oldSize;
+    count(newSize);
+    return block + 1;
+  }
+
+private:
+  void count(size_t size) {
+    bytes += size;
+    if (bytes > peak) peak = bytes;
+  }
+};
+
+static std::string modelJson; //misc/model.json
+static std::string modelMsgPack;
+
+static unsigned long microsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void test_fixture() {
+  std::ifstream file("misc/model.json");
+  std::stringstream text;
+  text << file.rdbuf();
+  modelJson = text.str();
+
+  JsonDocument doc;
+  TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, modelJson), "misc/model.json");
+  TEST_ASSERT_TRUE(doc.is<JsonArray>());
+  serializeMsgPack(doc, modelMsgPack);
+  TEST_ASSERT_TRUE(modelMsgPack.size() > 0);
+}
+
+//read both 100 times, as at boot: from a read only buffer (strings are copied into the document), NestingLimit(20)
+void test_boot_benchmark() {
+  const int runs = 100;
+  unsigned long jsonTime = 0, snapshotTime = 0;
+  size_t jsonPeak = 0, snapshotPeak = 0;
+
+  for (int run = 0; run < runs; run++) {
+    PeakAllocator allocator;
+    JsonDocument doc(&allocator);
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_FALSE(deserializeJson(doc, (const char *)modelJson.c_str(), DeserializationOption::NestingLimit(20)));
+    jsonTime += microsSince(start);
+    jsonPeak = allocator.peak;
+  }
+
+  for (int run = 0; run < runs; run++) {
+    PeakAllocator allocator;
+    JsonDocument doc(&allocator);
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_FALSE(deserializeMsgPack(doc, (const char *)modelMsgPack.data(), modelMsgPack.size(), DeserializationOption::NestingLimit(20)));
+    snapshotTime += microsSince(start);
+    snapshotPeak = allocator.peak;
+  }
+
+  //same model
+  JsonDocument jsonDoc, snapshotDoc;
+  deserializeJson(jsonDoc, modelJson);
+  deserializeMsgPack(snapshotDoc, modelMsgPack.data(), modelMsgPack.size());
+  TEST_ASSERT_TRUE(jsonDoc.as<JsonVariantConst>() == snapshotDoc.as<JsonVariantConst>());
+
+  char message[160];
+  snprintf(message, sizeof(message), "json %u B: %.1f µs (peak %u B), mpk %u B: %.1f µs (peak %u B)",
+    (unsigned)modelJson.size(), (float)jsonTime / runs, (unsigned)jsonPeak,
+    (unsigned)modelMsgPack.size(), (float)snapshotTime / runs, (unsigned)snapshotPeak);
+  TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixture);
+  RUN_TEST(test_boot_benchmark);
+  return UNITY_END();
+}